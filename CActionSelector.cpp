@@ -0,0 +1,160 @@
+#include "CActionSelector.h"
+#include "CRandom.h"
+#include "utils.h"
+#include <vector>
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//number of set bits in a 4 bit tie mask
+static const uint32_t TieCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+//TieChoice[mask][k] is the index of the k-th set bit of the tie mask
+static const int TieChoice[16][NUM_ACTIONS] = {{0, 0, 0, 0},
+											   {0, 0, 0, 0},
+											   {1, 0, 0, 0},
+											   {0, 1, 0, 0},
+											   {2, 0, 0, 0},
+											   {0, 2, 0, 0},
+											   {1, 2, 0, 0},
+											   {0, 1, 2, 0},
+											   {3, 0, 0, 0},
+											   {0, 3, 0, 0},
+											   {1, 3, 0, 0},
+											   {0, 1, 3, 0},
+											   {2, 3, 0, 0},
+											   {0, 2, 3, 0},
+											   {1, 2, 3, 0},
+											   {0, 1, 2, 3}};
+
+//----------------------------PickAction--------------------------------
+//
+//	final step shared by both kernels: the top two random bits give the
+//	exploratory action, the low 16 bits choose uniformly between the tied
+//	best actions (multiply-shift instead of a modulo)
+//
+//-----------------------------------------------------------------------
+static inline int PickAction(bool explore, uint32_t ties, uint32_t bits)
+{
+	if (explore) return (int)(bits >> 30);
+
+	return TieChoice[ties][((bits & 0xFFFF) * TieCount[ties]) >> 16];
+}
+
+void SelectActionsScalar(const float * values, const float * explore, const uint32_t * randomBits,
+						 float epsilon, int * actions, uint n)
+{
+	for (uint i = 0; i < n; ++i)
+	{
+		const float * v = values + i * NUM_ACTIONS;
+		float best = MaxValue(v);
+
+		uint32_t ties = 0;
+		for (uint a = 0; a < NUM_ACTIONS; ++a)
+		{
+			if (v[a] == best) ties |= 1 << a;
+		}
+
+		actions[i] = PickAction(explore[i] < epsilon, ties, randomBits[i]);
+	}
+}
+
+#if defined(__AVX2__)
+
+void SelectActions(const float * values, const float * explore, const uint32_t * randomBits,
+				   float epsilon, int * actions, uint n)
+{
+	const __m256 eps = _mm256_set1_ps(epsilon);
+
+	uint i = 0;
+
+	//eight states per pass: one epsilon compare and four 2-state argmaxes
+	for (; i + 8 <= n; i += 8)
+	{
+		int exploreMask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(explore + i), eps, _CMP_LT_OQ));
+
+		uint32_t ties[8];
+
+		for (uint pair = 0; pair < 4; ++pair)
+		{
+			__m256 v = _mm256_loadu_ps(values + (i + 2 * pair) * NUM_ACTIONS);
+
+			//broadcast the maximum of each group of four lanes across the group
+			__m256 m = _mm256_max_ps(v, _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)));
+			m = _mm256_max_ps(m, _mm256_permute_ps(m, _MM_SHUFFLE(1, 0, 3, 2)));
+
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(v, m, _CMP_EQ_OQ));
+
+			ties[2 * pair] = mask & 0xF;
+			ties[2 * pair + 1] = (mask >> 4) & 0xF;
+		}
+
+		for (uint k = 0; k < 8; ++k)
+		{
+			actions[i + k] = PickAction(((exploreMask >> k) & 1) != 0, ties[k], randomBits[i + k]);
+		}
+	}
+
+	//whatever is left over goes through the scalar kernel
+	SelectActionsScalar(values + i * NUM_ACTIONS, explore + i, randomBits + i, epsilon, actions + i, n - i);
+}
+
+#else
+
+void SelectActions(const float * values, const float * explore, const uint32_t * randomBits,
+				   float epsilon, int * actions, uint n)
+{
+	SelectActionsScalar(values, explore, randomBits, epsilon, actions, n);
+}
+
+#endif
+
+//-----------------------BenchmarkActionSelection------------------------
+//
+//	microbenchmark of the per-tick action selection: n states with small
+//	random values (so there are plenty of ties), repeated to get a stable
+//	time. Also checks that both kernels agree.
+//
+//-----------------------------------------------------------------------
+void BenchmarkActionSelection(uint n, uint repeats)
+{
+	CRandomStream rng(12345);
+
+	std::vector<float> values(n * NUM_ACTIONS);
+	std::vector<float> explore(n);
+	std::vector<uint32_t> bits(n);
+	std::vector<int> simdActions(n), scalarActions(n);
+
+	for (uint i = 0; i < values.size(); ++i)
+	{
+		values[i] = (float)rng.RandInt(-2, 2);
+	}
+	rng.FillFloat(&explore[0], n);
+	rng.FillUint(&bits[0], n);
+
+	double start = HighResTime();
+	for (uint r = 0; r < repeats; ++r)
+	{
+		SelectActions(&values[0], &explore[0], &bits[0], 0.1f, &simdActions[0], n);
+	}
+	double simdTime = HighResTime() - start;
+
+	start = HighResTime();
+	for (uint r = 0; r < repeats; ++r)
+	{
+		SelectActionsScalar(&values[0], &explore[0], &bits[0], 0.1f, &scalarActions[0], n);
+	}
+	double scalarTime = HighResTime() - start;
+
+	std::cout << "Action selection, " << n << " states:" << std::endl;
+#if defined(__AVX2__)
+	std::cout << "  AVX2:   " << simdTime / ((double)n * repeats) * 1e9 << " ns per state" << std::endl;
+#else
+	std::cout << "  SelectActions (built without AVX2, so the scalar kernel): "
+			  << simdTime / ((double)n * repeats) * 1e9 << " ns per state" << std::endl;
+#endif
+	std::cout << "  scalar: " << scalarTime / ((double)n * repeats) * 1e9 << " ns per state" << std::endl;
+	std::cout << "  kernels " << (simdActions == scalarActions ? "agree" : "DISAGREE") << std::endl;
+}
@@ -0,0 +1,48 @@
+#ifndef CACTIONSELECTOR_H
+#define CACTIONSELECTOR_H
+//------------------------------------------------------------------------
+//
+//	Name: CActionSelector.h
+//
+//  Desc: Batch epsilon-greedy action selection. The Q values of every live
+//        sweeper's current state are gathered into one buffer and all the
+//        actions are picked in a single pass: an AVX2 argmax over the four
+//        action values of two states per register, random tie-breaking
+//        between equal values and an epsilon mask over eight draws at a
+//        time. Builds without AVX2 (/arch:AVX2 or -mavx2) use the scalar
+//        version, which returns exactly the same actions.
+//
+//------------------------------------------------------------------------
+#include <stdint.h>
+#include "CQTable.h"
+
+//picks an epsilon-greedy action for each of n states:
+//	values     - n * NUM_ACTIONS Q values, state i's values start at values[i * NUM_ACTIONS]
+//	             (as floats whatever the table stores - exact for the int and fixed point tables)
+//	explore    - n uniform draws in [0,1), state i explores if explore[i] < epsilon
+//	randomBits - n random words used for the random action and for tie-breaking
+void SelectActions(const float * values, const float * explore, const uint32_t * randomBits,
+				   float epsilon, int * actions, uint n);
+
+//portable version of the above
+void SelectActionsScalar(const float * values, const float * explore, const uint32_t * randomBits,
+						 float epsilon, int * actions, uint n);
+
+//returns the largest of the NUM_ACTIONS values of a state
+template <class T>
+inline T MaxValue(const T * values)
+{
+	T best = values[0];
+
+	for (uint a = 1; a < NUM_ACTIONS; ++a)
+	{
+		if (values[a] > best) best = values[a];
+	}
+
+	return best;
+}
+
+//times the SIMD and scalar kernels on n random states and prints the results
+void BenchmarkActionSelection(uint n, uint repeats);
+
+#endif
@@ -111,21 +111,21 @@ bool CBackPropController::Update(void)
 	for (auto s = m_vecSweepers.begin(); s != m_vecSweepers.end(); ++s)
 	{		
 		//compute the dot between the look vector and vector to the closest mine:
-		double dot_mine = dot_between_vlook_and_vObject(**s,*m_vecObjects[(*s)->getClosestMine()]);
-		double dot_rock = dot_between_vlook_and_vObject(**s,*m_vecObjects[(*s)->getClosestRock()]);
-		double dot_supermine = dot_between_vlook_and_vObject(**s,*m_vecObjects[(*s)->getClosestSupermine()]);
-		double dist_rock = Vec2DLength(m_vecObjects[(*s)->getClosestRock()]->getPosition() - (*s)->Position());
-		double dist_supermine = Vec2DLength(m_vecObjects[(*s)->getClosestSupermine()]->getPosition() - (*s)->Position());
+		double dot_mine = dot_between_vlook_and_vObject(**s,m_vecObjects[(*s)->getClosestMine()]);
+		double dot_rock = dot_between_vlook_and_vObject(**s,m_vecObjects[(*s)->getClosestRock()]);
+		double dot_supermine = dot_between_vlook_and_vObject(**s,m_vecObjects[(*s)->getClosestSupermine()]);
+		double dist_rock = Vec2DLength(m_vecObjects[(*s)->getClosestRock()].getPosition() - (*s)->Position());
+		double dist_supermine = Vec2DLength(m_vecObjects[(*s)->getClosestSupermine()].getPosition() - (*s)->Position());
 
 		//cheat a bit here... passing the distance into the neural net as well increases the search space dramatrically... :
 		double dots[2] = { dot_mine, (dist_rock < 50 || dist_supermine < 50) ? ((dist_rock < dist_supermine) ? dot_rock : dot_supermine) : -1}; 
-		std::vector<double> dotsVector(dots, dots + 2);
+		_netInputs.assign(dots, dots + 2);
 
 		// turn towards the mine
-		if (_neuralnet->classify(dotsVector) == 0)
+		if (_neuralnet->classify(_netInputs) == 0)
 		{ 
-			SPoint pt(m_vecObjects[(*s)->getClosestMine()]->getPosition().x,
-					  m_vecObjects[(*s)->getClosestMine()]->getPosition().y); 
+			SPoint pt(m_vecObjects[(*s)->getClosestMine()].getPosition().x,
+					  m_vecObjects[(*s)->getClosestMine()].getPosition().y); 
 			(*s)->turn(pt,1);
 		} 
 		//turn away from a rock or supermine
@@ -133,14 +133,14 @@ bool CBackPropController::Update(void)
 		{
 			if (dist_rock < dist_supermine)
 			{
-				SPoint pt(m_vecObjects[(*s)->getClosestRock()]->getPosition().x,
-					  m_vecObjects[(*s)->getClosestRock()]->getPosition().y); 
+				SPoint pt(m_vecObjects[(*s)->getClosestRock()].getPosition().x,
+					  m_vecObjects[(*s)->getClosestRock()].getPosition().y); 
 				(*s)->turn(pt,1,false);
 			} 
 			else 
 			{
-				SPoint pt(m_vecObjects[(*s)->getClosestSupermine()]->getPosition().x,
-					  m_vecObjects[(*s)->getClosestSupermine()]->getPosition().y); 
+				SPoint pt(m_vecObjects[(*s)->getClosestSupermine()].getPosition().x,
+					  m_vecObjects[(*s)->getClosestSupermine()].getPosition().y); 
 				(*s)->turn(pt,1,false);
 			}
 		}
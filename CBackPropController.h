@@ -1,5 +1,5 @@
 #pragma once
-#include "ccontcontroller.h"
+#include "CContController.h"
 #include "CNeuralNet.h"
 #include <assert.h>
 class CBackPropController :
@@ -7,6 +7,7 @@ class CBackPropController :
 {
 protected:
 	CNeuralNet* _neuralnet;
+	std::vector<double> _netInputs; // the two dot products fed to the network, reused every tick
 public:
 	CBackPropController(HWND hwndMain);
 	virtual void InitializeLearningAlgorithm(void);
@@ -0,0 +1,52 @@
+#include "CBitboard.h"
+#include <string.h>
+
+void CBitboard::Reset()
+{
+	if (!m_vecWords.empty()) memset(&m_vecWords[0], 0, Bytes());
+}
+
+void CBitboard::CopyFrom(const CBitboard &other)
+{
+	if (m_vecWords.size() != other.m_vecWords.size())
+	{
+		m_vecWords = other.m_vecWords;
+		m_iCells = other.m_iCells;
+
+		return;
+	}
+
+	if (!m_vecWords.empty()) memcpy(&m_vecWords[0], &other.m_vecWords[0], Bytes());
+}
+
+uint CBitboard::Count()const
+{
+	uint count = 0;
+
+	for (size_t w = 0; w < m_vecWords.size(); ++w) count += PopCount(m_vecWords[w]);
+
+	return count;
+}
+
+//-------------------------------NextSet()--------------------------------
+//
+//	skips whole empty words, so walking the set cells of a sparse board
+//	costs one load per 64 cells plus one step per set cell
+//
+//------------------------------------------------------------------------
+int CBitboard::NextSet(uint cell)const
+{
+	if (cell >= m_iCells) return -1;
+
+	size_t w = cell >> 6;
+	uint64_t word = m_vecWords[w] & (~(uint64_t)0 << (cell & 63));
+
+	while (word == 0)
+	{
+		if (++w == m_vecWords.size()) return -1;
+
+		word = m_vecWords[w];
+	}
+
+	return (int)(w * 64 + LowestBit(word));
+}
@@ -0,0 +1,89 @@
+#ifndef CBITBOARD_H
+#define CBITBOARD_H
+//------------------------------------------------------------------------
+//
+//	Name: CBitboard.h
+//
+//  Desc: One bit per grid cell, packed 64 cells to a word. The discrete
+//        controller's bitboard world keeps the live objects of each type,
+//        the cells they started on and the cells the sweepers have visited
+//        in these, so a world of millions of cells costs a few bits per
+//        cell. Counting, copying and clearing work a word (64 cells) at a
+//        time.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+typedef unsigned int uint;
+
+//number of set bits of a word
+inline int PopCount(uint64_t word)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(word);
+#else
+	//no POPCNT requirement on the 32 bit build
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+//index of the lowest set bit of a non zero word
+inline int LowestBit(uint64_t word)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)word)) return (int)index;
+	_BitScanForward(&index, (unsigned long)(word >> 32));
+	return (int)index + 32;
+#endif
+}
+
+class CBitboard
+{
+private:
+	std::vector<uint64_t>	m_vecWords;
+	uint					m_iCells;
+
+public:
+	CBitboard():m_iCells(0){}
+
+	//(re)sizes the board to a number of cells, all clear
+	void		Allocate(uint cells)
+	{
+		m_iCells = cells;
+		m_vecWords.assign((cells + 63) / 64, 0);
+	}
+
+	bool		Test(uint cell)const{return (m_vecWords[cell >> 6] >> (cell & 63)) & 1;}
+	void		Set(uint cell){m_vecWords[cell >> 6] |= (uint64_t)1 << (cell & 63);}
+	void		Clear(uint cell){m_vecWords[cell >> 6] &= ~((uint64_t)1 << (cell & 63));}
+
+	//clears every cell
+	void		Reset();
+
+	//copies another board of the same size (a memcpy)
+	void		CopyFrom(const CBitboard &other);
+
+	//number of set cells
+	uint		Count()const;
+
+	//first set cell at or after a cell, -1 if there is none
+	int			NextSet(uint cell)const;
+
+	//-------------------accessor functions
+	uint		Cells()const{return m_iCells;}
+	size_t		Bytes()const{return m_vecWords.size() * sizeof(uint64_t);}
+};
+
+#endif
@@ -1,18 +1,9 @@
 #pragma once
+//the object types shared by both environments. The objects themselves live
+//in a CObjectPool, one per controller
 class CCollisionObject
 {
 public:
 	enum ObjectType { Mine, SuperMine, Rock };
-protected:
-	ObjectType m_ObjectType;
-	bool m_bDead;
-public:
-	CCollisionObject(ObjectType objectType);
-	virtual ~CCollisionObject(void);
-	void setType(ObjectType objectType);
-	ObjectType getType();
-	void Reset();
-	void die();
-	bool isDead() const;
+	static const int NUM_OBJECT_TYPES = 3;
 };
-
@@ -1,19 +1,11 @@
 #ifndef CContCOLLISIONOBJECT_H
 #define CContCOLLISIONOBJECT_H
 #include "SVector2D.h"
-#include "CCollisionObject.h"
-class CContCollisionObject: public CCollisionObject
-{
-public:
-	CContCollisionObject();
-	CContCollisionObject(ObjectType objectType, SVector2D<double> position);
-	virtual ~CContCollisionObject();
+#include "CObjectPool.h"
 
-	void setPosition(SVector2D<double> position);
-	SVector2D<double> getPosition() const;
-	
-private:
-	SVector2D<double> * m_vPosition;
-};
+//continuous objects sit anywhere in the window; each one is a slot of
+//the controller's object pool
+typedef CObjectPool<double> CContObjectPool;
+typedef CObjectRef<double> CContCollisionObject;
 
-#endif
\ No newline at end of file
+#endif
@@ -2,15 +2,14 @@
 
 
 CContController::CContController(HWND hwndMain):
-	CController(hwndMain)
+	CController(hwndMain),
+	m_iMovedTypes(0)
 {
 	
 }
 
 CContController::~CContController(void)
 {
-	for (auto i = m_vecObjects.begin(); i != m_vecObjects.end(); ++i)
-		delete *i;
 	for (auto i = m_vecSweepers.begin(); i != m_vecSweepers.end(); ++i)
 		delete *i;
 }
@@ -21,13 +20,20 @@ void CContController::InitializeLearningAlgorithm(void)
 	This is the basic continious environment so there are no learning algorithms
 	to initialize yet...
 	*/
+	m_Grid.Build(m_vecObjects, cxClient, cyClient);
+
+	//a sweeper changes at most one object a tick, so the per tick buffers
+	//are sized once here and a tick never allocates
+	m_vecStepHits.resize(m_NumSweepers);
+	m_vecChangedObjects.reserve(m_NumSweepers);
+	m_vecObjectChanged.resize(m_vecObjects.size());
 }
 
 void CContController::InitializeSweepers(void)
 {
 	for (int i=0; i<m_NumSweepers; ++i)
 	{
-		m_vecSweepers.push_back(new CContMinesweeper());
+		m_vecSweepers.push_back(new CContMinesweeper(CRandomService::Stream(CRandomService::Sweeper, i)));
 	}
 }
 
@@ -35,8 +41,8 @@ void CContController::InitializeMines(void)
 {
 	for (int i=0; i<m_NumMines; ++i)
 	{
-		m_vecObjects.push_back(new CContCollisionObject(CCollisionObject::Mine, SVector2D<double>(RandFloat() * cxClient,
-                                   RandFloat() * cyClient)));
+		m_vecObjects.Add(CCollisionObject::Mine, SVector2D<double>(m_Rng.RandFloat() * cxClient,
+                         m_Rng.RandFloat() * cyClient));
 	}
 }
 
@@ -44,8 +50,8 @@ void CContController::InitializeSuperMines(void)
 {
 	for (int i=0; i<m_NumSuperMines; ++i)
 	{
-		m_vecObjects.push_back(new CContCollisionObject(CCollisionObject::SuperMine, SVector2D<double>(RandFloat() * cxClient,
-                                   RandFloat() * cyClient)));
+		m_vecObjects.Add(CCollisionObject::SuperMine, SVector2D<double>(m_Rng.RandFloat() * cxClient,
+                         m_Rng.RandFloat() * cyClient));
 	}
 }
 
@@ -53,8 +59,8 @@ void CContController::InitializeRocks(void)
 {
 	for (int i=0; i<m_NumRocks; ++i)
 	{
-		m_vecObjects.push_back(new CContCollisionObject(CCollisionObject::Rock, SVector2D<double>(RandFloat() * cxClient,
-                                   RandFloat() * cyClient)));
+		m_vecObjects.Add(CCollisionObject::Rock, SVector2D<double>(m_Rng.RandFloat() * cxClient,
+                         m_Rng.RandFloat() * cyClient));
 	}
 }
 
@@ -71,38 +77,97 @@ bool CContController::Update()
 	//information from its surroundings. The output from the learning algorithm is obtained
 	//and the sweeper is moved. If it encounters a mine its MinesGathered is
 	//updated appropriately,
+
+	//a replayed episode ends where the recorded one did (this also reads past
+	//the end of the tick list when it runs the full length)
+	if (m_pPlayer && !m_pPlayer->BeginTick())
+	{
+		m_iTicks = CParams::iNumTicks;
+	}
+
 	if (m_iTicks++ < CParams::iNumTicks)
 	{
+		//the turns were made at the end of the last update, by the learning algorithm
+		if (m_pPlayer)
+			ReplayTick();
+		else if (m_pRecorder && m_pRecorder->EpisodeOpen())
+			RecordTick();
+
+		//move every live sweeper and see what it has run into, as the world
+		//stood at the start of the tick. Each sweeper only writes to itself
+		//here, so this can be split up
+		m_vecStepHits.resize(m_NumSweepers);
+
+		auto sweepStep = [&](uint begin, uint end)
+		{
+			for (uint i=begin; i<end; ++i)
+			{
+				if (m_vecSweepers[i]->isDead()) continue; //skip if dead
+				//update the position
+				if (!(m_vecSweepers[i])->Update(m_vecObjects, m_Grid))
+				{
+					m_vecStepHits[i] = STEP_FAILED;
+					continue;
+				}
+
+				//see if it's found a mine
+				m_vecStepHits[i] = (m_vecSweepers[i])->CheckForObject(m_vecObjects,
+														CParams::dMineScale);
+			}
+		};
+
+		m_Workers.ParallelFor(m_NumSweepers, MIN_STEP_CHUNK, sweepStep);
+
+		//then the collisions take effect in sweeper order. A mine that respawns
+		//or a supermine that dies can change what a later sweeper is closest to -
+		//when it does, that sweeper looks again, as it would have stepping after
+		//the change
+		for (size_t c=0; c<m_vecChangedObjects.size(); ++c)
+		{
+			m_vecObjectChanged[m_vecChangedObjects[c]] = 0;
+		}
+
+		m_vecChangedObjects.clear();
+		m_vecObjectChanged.resize(m_vecObjects.size());
+		m_iMovedTypes = 0;
+
 		for (int i=0; i<m_NumSweepers; ++i)
 		{
 			if (m_vecSweepers[i]->isDead()) continue; //skip if dead
-			//update the position
-			if (!(m_vecSweepers[i])->Update(m_vecObjects))
+
+			if (m_vecStepHits[i] == STEP_FAILED)
 			{
 				//error in processing the learning algorithm
 				MessageBox(m_hwndMain, "An error occured while processing!", "Error", MB_OK);
 
 				return false;
 			}
-				
-			//see if it's found a mine
-			int GrabHit = (m_vecSweepers[i])->CheckForObject(m_vecObjects,
-													CParams::dMineScale);
+
+			int GrabHit = m_vecStepHits[i];
+
+			if (!m_vecChangedObjects.empty() &&
+				(m_vecSweepers[i])->ClosestMayChange(m_vecObjects, m_Grid, m_vecObjectChanged, m_iMovedTypes))
+			{
+				(m_vecSweepers[i])->GetClosestObjects(m_vecObjects, m_Grid);
+				GrabHit = (m_vecSweepers[i])->CheckForObject(m_vecObjects, CParams::dMineScale);
+			}
 
 			if (GrabHit >= 0)
 			{
-				switch(m_vecObjects[GrabHit]->getType()){
+				switch(m_vecObjects[GrabHit].getType()){
 				case CContCollisionObject::Mine:
 					{
 					//we have discovered a mine so increase MinesGathered
 					(m_vecSweepers[i])->IncrementMinesGathered();
 
 					//mine found so replace the mine with another at a random 
-					//position
-					CContCollisionObject* oldObject = m_vecObjects[GrabHit];
-					m_vecObjects[GrabHit] = new CContCollisionObject(oldObject->getType(),SVector2D<double>(RandFloat() * cxClient,
-											RandFloat() * cyClient));
-					delete oldObject;
+					//position (the pool slot is reused)
+					m_vecObjects[GrabHit].setPosition(SVector2D<double>(m_Rng.RandFloat() * cxClient,
+											m_Rng.RandFloat() * cyClient));
+					m_Grid.Move(m_vecObjects, GrabHit);
+					m_vecChangedObjects.push_back(GrabHit);
+					m_vecObjectChanged[GrabHit] = 1;
+					m_iMovedTypes |= 1 << CCollisionObject::Mine;
 					break;
 					}
 				case CContCollisionObject::Rock:
@@ -116,8 +181,10 @@ bool CContController::Update()
 				case CContCollisionObject::SuperMine:
 					{
 					//destroy both the sweeper and the supermine until they reincarnate in the next round
-					CContCollisionObject* oldObject = m_vecObjects[GrabHit];
-					oldObject->die();
+					m_vecObjects[GrabHit].die();
+					m_Grid.Remove(m_vecObjects, GrabHit);
+					m_vecChangedObjects.push_back(GrabHit);
+					m_vecObjectChanged[GrabHit] = 1;
 																
 					(m_vecSweepers[i])->die();
 					break;
@@ -137,13 +204,16 @@ bool CContController::Update()
 			sum += (*i)->MinesGathered();
 			if ((*i)->isDead())
 				deaths++;
-			maxMines = max((*i)->MinesGathered(),maxMines);
+			if ((*i)->MinesGathered() > maxMines)
+				maxMines = (int)(*i)->MinesGathered();
 		}
 		
 		m_vecAvMinesGathered.push_back(sum/float(m_vecSweepers.size()));
 		m_vecMostMinesGathered.push_back(maxMines);
 		m_vecDeaths.push_back(deaths);
 
+		EndTraceEpisode(deaths, sum);
+
 
 		//PRINT TO CONSOLE//
 		std::cout << "\n======================================\n	--> ITERATION: " << m_iIterations << " <--	\n======================================\n" << std::endl;
@@ -159,21 +229,207 @@ bool CContController::Update()
 		m_iTicks = 0;	
 		
 
-		//reset the sweepers positions etc
-		for (int i=0; i<m_NumSweepers; ++i)
+		//a replay goes back to the start of its episode, a scenario bank gives the
+		//next layout and anything else gets a new random start
+		if (!RewindReplay() && !NextScenario())
+		{
+			//reset the sweepers positions etc
+			for (int i=0; i<m_NumSweepers; ++i)
+			{
+				(m_vecSweepers[i])->Reset();
+			}
+			//reset supermine
+			for (int i = 0; i < m_NumMines+m_NumRocks+m_NumSuperMines; ++i)
+			{
+				if (m_vecObjects[i].getType() == CCollisionObject::ObjectType::SuperMine)
+					m_vecObjects[i].Reset();
+			}
+
+			m_Grid.Build(m_vecObjects, cxClient, cyClient);
+		}
+
+		BeginTraceEpisode();
+	}
+	return true;
+}
+
+void CContController::ApplyScenario(int layout)
+{
+	SScenarioLayout<double> scenario = m_pScenarios->Layout<double>(layout);
+
+	m_vecObjects.Assign(scenario.objectX, scenario.objectY, scenario.objectType);
+
+	for (int i=0; i<m_NumSweepers; ++i)
+	{
+		(m_vecSweepers[i])->Place(SVector2D<double>(scenario.spawnX[i], scenario.spawnY[i]),
+								  scenario.spawnRotation[i], (m_vecSweepers[i])->getSpeed());
+	}
+
+	m_Grid.Build(m_vecObjects, cxClient, cyClient);
+}
+
+//-------------------------------RecordLayout-------------------------------
+//
+//	everything is stored raw, positions and rotations are doubles. The state
+//	of the environment's stream goes in too, since the mines that are found
+//	respawn at positions drawn from it
+//
+//-------------------------------------------------------------------------
+void CContController::RecordLayout(void)
+{
+	uint32_t state[4];
+	m_Rng.GetState(state);
+
+	for (int k = 0; k < 4; ++k) m_pRecorder->PutVarint(state[k]);
+
+	m_pRecorder->PutVarint(m_vecObjects.size());
+
+	for (int i = 0; i < (int)m_vecObjects.size(); ++i)
+	{
+		SVector2D<double> position = m_vecObjects.Position(i);
+
+		m_pRecorder->PutVarint(m_vecObjects.Type(i) | (m_vecObjects.Alive(i) ? 4 : 0));
+		m_pRecorder->PutRaw(&position.x, sizeof(double));
+		m_pRecorder->PutRaw(&position.y, sizeof(double));
+	}
+
+	m_pRecorder->PutVarint(m_vecSweepers.size());
+	m_vecTraceRotation.resize(m_vecSweepers.size());
+	m_vecTraceSpeed.resize(m_vecSweepers.size());
+
+	for (int i = 0; i < (int)m_vecSweepers.size(); ++i)
+	{
+		SVector2D<double> position = m_vecSweepers[i]->Position();
+
+		m_vecTraceRotation[i] = m_vecSweepers[i]->getRotation();
+		m_vecTraceSpeed[i] = m_vecSweepers[i]->getSpeed();
+
+		m_pRecorder->PutRaw(&position.x, sizeof(double));
+		m_pRecorder->PutRaw(&position.y, sizeof(double));
+		m_pRecorder->PutRaw(&m_vecTraceRotation[i], sizeof(double));
+		m_pRecorder->PutRaw(&m_vecTraceSpeed[i], sizeof(double));
+	}
+}
+
+bool CContController::ReplayLayout(void)
+{
+	uint32_t state[4];
+
+	for (int k = 0; k < 4; ++k) state[k] = (uint32_t)m_pPlayer->GetVarint();
+
+	m_Rng.SetState(state);
+
+	if (m_pPlayer->GetVarint() != m_vecObjects.size()) return false;
+
+	for (int i = 0; i < (int)m_vecObjects.size(); ++i)
+	{
+		uint code = (uint)m_pPlayer->GetVarint();
+		SVector2D<double> position;
+
+		m_pPlayer->GetRaw(&position.x, sizeof(double));
+		m_pPlayer->GetRaw(&position.y, sizeof(double));
+
+		m_vecObjects.SetType(i, (CCollisionObject::ObjectType)(code & 3));
+		m_vecObjects.SetPosition(i, position);
+
+		if (code & 4) m_vecObjects.Revive(i); else m_vecObjects.Kill(i);
+	}
+
+	m_Grid.Build(m_vecObjects, cxClient, cyClient);
+
+	if (m_pPlayer->GetVarint() != m_vecSweepers.size()) return false;
+
+	m_vecTraceRotation.resize(m_vecSweepers.size());
+	m_vecTraceSpeed.resize(m_vecSweepers.size());
+
+	for (int i = 0; i < (int)m_vecSweepers.size(); ++i)
+	{
+		SVector2D<double> position;
+
+		m_pPlayer->GetRaw(&position.x, sizeof(double));
+		m_pPlayer->GetRaw(&position.y, sizeof(double));
+		m_pPlayer->GetRaw(&m_vecTraceRotation[i], sizeof(double));
+		m_pPlayer->GetRaw(&m_vecTraceSpeed[i], sizeof(double));
+
+		m_vecSweepers[i]->Place(position, m_vecTraceRotation[i], m_vecTraceSpeed[i]);
+	}
+
+	return !m_pPlayer->Failed();
+}
+
+//-------------------------------RecordTick---------------------------------
+//
+//	a live sweeper either keeps its heading (0) or has turned by the full
+//	rate one way (1) or the other (2). A replay redoes the same sum, so
+//	the turns come out bit for bit. Anything else, a change of speed
+//	included, is an escape (3) with the raw values
+//
+//-------------------------------------------------------------------------
+void CContController::RecordTick(void)
+{
+	const double step = (1.0*MAX_TURNING_RATE_IN_DEGREES)*CParams::dPi/180;
+
+	m_vecTraceSymbols.clear();
+	m_pRecorder->BeginTick();
+
+	for (int i=0; i<m_NumSweepers; ++i)
+	{
+		if (m_vecSweepers[i]->isDead()) continue;
+
+		double rotation = m_vecSweepers[i]->getRotation();
+		double speed = m_vecSweepers[i]->getSpeed();
+		int32_t symbol = 3;
+
+		if (speed == m_vecTraceSpeed[i])
 		{
-			(m_vecSweepers[i])->Reset();
+			if (rotation == m_vecTraceRotation[i])
+				symbol = 0;
+			else if (rotation == m_vecTraceRotation[i] + step)
+				symbol = 1;
+			else if (rotation == m_vecTraceRotation[i] - step)
+				symbol = 2;
 		}
-		//reset supermine
-		for (int i = 0; i < m_NumMines+m_NumRocks+m_NumSuperMines; ++i)
+
+		if (symbol == 3)
 		{
-			if (m_vecObjects[i]->getType() == CCollisionObject::ObjectType::SuperMine)
-				m_vecObjects[i]->Reset();
+			m_pRecorder->PutEscape(&rotation, sizeof(double));
+			m_pRecorder->PutEscape(&speed, sizeof(double));
 		}
+
+		m_vecTraceSymbols.push_back(symbol);
+		m_vecTraceRotation[i] = rotation;
+		m_vecTraceSpeed[i] = speed;
 	}
-	return true;
+
+	m_pRecorder->PutSymbols(m_vecTraceSymbols.empty() ? NULL : &m_vecTraceSymbols[0], m_vecTraceSymbols.size());
+	m_pRecorder->EndTick();
 }
 
+void CContController::ReplayTick(void)
+{
+	const double step = (1.0*MAX_TURNING_RATE_IN_DEGREES)*CParams::dPi/180;
+
+	for (int i=0; i<m_NumSweepers; ++i)
+	{
+		if (m_vecSweepers[i]->isDead()) continue;
+
+		switch (m_pPlayer->GetSymbol())
+		{
+		case 1: m_vecTraceRotation[i] += step; break;
+		case 2: m_vecTraceRotation[i] -= step; break;
+		case 3:
+			m_pPlayer->GetEscape(&m_vecTraceRotation[i], sizeof(double));
+			m_pPlayer->GetEscape(&m_vecTraceSpeed[i], sizeof(double));
+			break;
+		}
+
+		m_vecSweepers[i]->setRotation(m_vecTraceRotation[i]);
+		m_vecSweepers[i]->setSpeed(m_vecTraceSpeed[i] / MAX_SPEED_IN_PIXELS);
+	}
+}
+
+#ifdef _WIN32
+
 //------------------------------------Render()--------------------------------------
 //
 //----------------------------------------------------------------------------------
@@ -191,23 +447,23 @@ void CContController::Render(HDC surface)
 		//render the mines
 		for (int i=0; i<m_NumMines+m_NumSuperMines+m_NumRocks; ++i)
 		{
-			if ((m_vecObjects[i])->isDead()) continue; //skip if dead
-			if ( (m_vecObjects[i])->getType() == CCollisionObject::Mine)
+			if (m_vecObjects[i].isDead()) continue; //skip if dead
+			if ( m_vecObjects[i].getType() == CCollisionObject::Mine)
 			{
 				SelectObject(surface, m_GreenPen);
 			}
-			else if ( (m_vecObjects[i])->getType() == CCollisionObject::Rock)
+			else if ( m_vecObjects[i].getType() == CCollisionObject::Rock)
 			{
 				SelectObject(surface, m_BluePen );
 			}
-			else if ( (m_vecObjects[i])->getType() == CCollisionObject::SuperMine)
+			else if ( m_vecObjects[i].getType() == CCollisionObject::SuperMine)
 			{
 				SelectObject(surface, m_RedPen);
 			}
 			//grab the vertices for the mine shape
 			vector<SPoint> mineVB = m_MineVB;
 
-			WorldTransform<double>(mineVB, (m_vecObjects[i])->getPosition());
+			WorldTransform<double>(mineVB, m_vecObjects[i].getPosition());
 
 			//draw the mines
 			MoveToEx(surface, (int)mineVB[0].x, (int)mineVB[0].y, NULL);
@@ -280,4 +536,6 @@ void CContController::Render(HDC surface)
     PlotStats(surface);
   }
 
-}
\ No newline at end of file
+}
+
+#endif
@@ -1,8 +1,13 @@
 #pragma once
-#include "ccontroller.h"
+#include "CController.h"
 #include "CContCollisionObject.h"
 #include "CContMinesweeper.h"
+#include "CSpatialGrid.h"
 #include <algorithm>
+
+//step hit of a sweeper whose Update failed
+const int STEP_FAILED = -2;
+
 class CContController :
 	public CController
 {
@@ -11,11 +16,43 @@ protected:
     vector<CContMinesweeper*> m_vecSweepers;
 
 	//and the mines
-	vector<CContCollisionObject*> m_vecObjects;
+	CContObjectPool m_vecObjects;
+
+	//where the live objects are, for the sweepers' closest object searches.
+	//Rebuilt whenever the objects are laid out and kept up to date as mines
+	//respawn and supermines die
+	CSpatialGrid m_Grid;
+
+	//rotation and speed of each sweeper as of the last recorded or replayed tick
+	vector<double> m_vecTraceRotation;
+	vector<double> m_vecTraceSpeed;
+	vector<int32_t> m_vecTraceSymbols;
+
+	//what each sweeper ran into this tick, and the objects that have been
+	//moved or destroyed so far this tick - listed, flagged per object and
+	//with a bit per type that has had one moved
+	vector<int> m_vecStepHits;
+	vector<int> m_vecChangedObjects;
+	vector<uint8_t> m_vecObjectChanged;
+	int m_iMovedTypes;
+
+	//episode traces: the environment's random stream, the objects and the
+	//sweepers, then a symbol per live sweeper per tick for the turn it made
+	virtual int TraceWorldType(void)const{return ContinuousTrace;}
+	virtual void RecordLayout(void);
+	virtual bool ReplayLayout(void);
+	void RecordTick(void);
+	void ReplayTick(void);
+
+	//scenario layouts: the mines move as they are found, so the objects are
+	//copied in every episode along with the spawns
+	virtual void ApplyScenario(int layout);
 public:
 	CContController(HWND hwndMain);
 	virtual ~CContController(void);
+#ifdef _WIN32
 	virtual void Render(HDC surface);
+#endif
 	virtual bool Update(void);
 	virtual void InitializeLearningAlgorithm(void);
 	virtual void InitializeSweepers(void);
@@ -3,14 +3,17 @@
 //-----------------------------------constructor-------------------------
 //
 //-----------------------------------------------------------------------
-CContMinesweeper::CContMinesweeper():
-							 CMinesweeper(),
-                             m_dRotation(RandFloat()*CParams::dTwoPi),
-							 m_dSpeed(MAX_SPEED_IN_PIXELS)
+CContMinesweeper::CContMinesweeper(const CRandomStream &rng):
+							 CMinesweeper(rng),
+                             m_dRotation(m_Rng.RandFloat()*CParams::dTwoPi),
+							 m_dSpeed(MAX_SPEED_IN_PIXELS),
+							 m_dClosestMineDistance(NO_OBJECT_DISTANCE),
+							 m_dClosestRockDistance(NO_OBJECT_DISTANCE),
+							 m_dClosestSupermineDistance(NO_OBJECT_DISTANCE)
 {
 	//create a random start position
-	m_vPosition = SVector2D<double>((RandFloat() * CParams::WindowWidth), 
-					                (RandFloat() * CParams::WindowHeight));
+	m_vPosition = SVector2D<double>((m_Rng.RandFloat() * CParams::WindowWidth), 
+					                (m_Rng.RandFloat() * CParams::WindowHeight));
 }
 
 //-------------------------------------------Reset()--------------------
@@ -22,16 +25,28 @@ void CContMinesweeper::Reset()
 {
 
 	//reset the sweepers positions
-	m_vPosition = SVector2D<double>((RandFloat() * CParams::WindowWidth), 
-					                (RandFloat() * CParams::WindowHeight));
+	m_vPosition = SVector2D<double>((m_Rng.RandFloat() * CParams::WindowWidth), 
+					                (m_Rng.RandFloat() * CParams::WindowHeight));
 	
 	CMinesweeper::Reset();
 
 	//and the rotation
-	m_dRotation = RandFloat()*CParams::dTwoPi;
+	m_dRotation = m_Rng.RandFloat()*CParams::dTwoPi;
 
 	return;
 }
+//-------------------------------------------Place()--------------------
+//
+//----------------------------------------------------------------------
+void CContMinesweeper::Place(SVector2D<double> position, double rotation, double speed)
+{
+	m_vPosition = position;
+	m_dRotation = rotation;
+	m_dSpeed = speed;
+
+	CMinesweeper::Reset();
+}
+
 //---------------------WorldTransform--------------------------------
 //
 //	sets up a translation matrix for the sweeper according to its
@@ -67,7 +82,7 @@ void CContMinesweeper::WorldTransform(vector<SPoint> &sweeper)
 //	and acceleration. This is then applied to current velocity vector.
 //
 //-----------------------------------------------------------------------
-bool CContMinesweeper::Update(vector<CContCollisionObject*> &objects)
+bool CContMinesweeper::Update(CContObjectPool &objects, const CSpatialGrid &grid)
 {
 	//update Look At 
 	m_vLookAt.x = cos(m_dRotation);
@@ -81,80 +96,92 @@ bool CContMinesweeper::Update(vector<CContCollisionObject*> &objects)
 	if (m_vPosition.x < 0) m_vPosition.x = CParams::WindowWidth;
 	if (m_vPosition.y > CParams::WindowHeight) m_vPosition.y = 0;
 	if (m_vPosition.y < 0) m_vPosition.y = CParams::WindowHeight;
-	GetClosestObjects(objects);	
+	GetClosestObjects(objects, grid);	
 	return true;
 }
 
 
 //----------------------GetClosestObject()---------------------------------
 //
-//	returns the vector from the sweeper to the closest mine
+//	finds the closest live object of each type through the grid. A type
+//	with none left keeps the index it had
 //
 //-----------------------------------------------------------------------
-void CContMinesweeper::GetClosestObjects(vector<CContCollisionObject*> &objects)
+void CContMinesweeper::GetClosestObjects(CContObjectPool &objects, const CSpatialGrid &grid)
 {
-	double			closest_mine_so_far = 99999, closest_rock_so_far = 99999, closest_super_mine_so_far = 99999;
+	if (!grid.Closest(objects, CCollisionObject::Mine, m_vPosition, m_iClosestMine, m_dClosestMineDistance))
+		m_dClosestMineDistance = NO_OBJECT_DISTANCE;
 
-	SVector2D<double>		vClosestObject(0, 0);
+	if (!grid.Closest(objects, CCollisionObject::Rock, m_vPosition, m_iClosestRock, m_dClosestRockDistance))
+		m_dClosestRockDistance = NO_OBJECT_DISTANCE;
 
-	//cycle through mines to find closest
-	for (int i=0; i<objects.size(); i++)
-	{
-		if (objects[i]->isDead()) continue; //skip if object was destroyed earlier
-		double len_to_object = Vec2DLength<double>(objects[i]->getPosition() - m_vPosition);
-
-		switch(objects[i]->getType()){
-		case CCollisionObject::ObjectType::Mine:
-			if (len_to_object < closest_mine_so_far)
-			{
-				closest_mine_so_far	= len_to_object;
-				vClosestObject	= objects[i]->getPosition()-m_vPosition;
-				m_iClosestMine = i;
-			}
-			break;
-		case CCollisionObject::ObjectType::Rock:
-			if (len_to_object < closest_rock_so_far)
-			{
-				closest_rock_so_far	= len_to_object;
-				vClosestObject	= objects[i]->getPosition()-m_vPosition;
-				m_iClosestRock = i;
-			}
-			break;
-		case CCollisionObject::ObjectType::SuperMine:
-			if (len_to_object < closest_super_mine_so_far)
-			{
-				closest_super_mine_so_far = len_to_object;
-				vClosestObject	= objects[i]->getPosition()-m_vPosition;
-				m_iClosestSupermine = i;
-			}
-			break;
-		}
-	}
+	if (!grid.Closest(objects, CCollisionObject::SuperMine, m_vPosition, m_iClosestSupermine, m_dClosestSupermineDistance))
+		m_dClosestSupermineDistance = NO_OBJECT_DISTANCE;
+}
+
+//----------------------ClosestMayChange()---------------------------------
+//
+//	if none of the closest objects has changed, an object that has gone
+//	cannot be any closer, and one that has moved only matters if the grid
+//	now finds it instead (a tie goes to the lower index, so a tie counts)
+//
+//-----------------------------------------------------------------------
+static bool SameClosest(CContObjectPool &objects, const CSpatialGrid &grid, int type,
+						SVector2D<double> position, int closest, double distance)
+{
+	int index;
+	double length;
+
+	if (!grid.Closest(objects, type, position, index, length)) return distance == NO_OBJECT_DISTANCE;
+
+	return index == closest && length == distance;
+}
+
+bool CContMinesweeper::ClosestMayChange(CContObjectPool &objects, const CSpatialGrid &grid,
+										const vector<uint8_t> &changed, int movedTypes) const
+{
+	if (changed[m_iClosestMine] || changed[m_iClosestRock] || changed[m_iClosestSupermine]) return true;
+
+	if ((movedTypes & (1 << CCollisionObject::Mine)) &&
+		!SameClosest(objects, grid, CCollisionObject::Mine, m_vPosition, m_iClosestMine, m_dClosestMineDistance))
+		return true;
+
+	if ((movedTypes & (1 << CCollisionObject::Rock)) &&
+		!SameClosest(objects, grid, CCollisionObject::Rock, m_vPosition, m_iClosestRock, m_dClosestRockDistance))
+		return true;
+
+	if ((movedTypes & (1 << CCollisionObject::SuperMine)) &&
+		!SameClosest(objects, grid, CCollisionObject::SuperMine, m_vPosition, m_iClosestSupermine, m_dClosestSupermineDistance))
+		return true;
+
+	return false;
 }
 //----------------------------- CheckForMine -----------------------------
 //
 //  this function checks for collision with its closest mine (calculated
-//  earlier and stored in m_iClosestMine)
+//  earlier and stored in m_iClosestMine), at the distance found then. A
+//  type with no live objects left still tests the object it last had
 //-----------------------------------------------------------------------
-int CContMinesweeper::CheckForObject(vector<CContCollisionObject*> &objects, double size)
+static double DistanceToClosest(CContObjectPool &objects, SVector2D<double> position, int index, double distance)
+{
+	if (distance != NO_OBJECT_DISTANCE) return distance;
+
+	return Vec2DLength<double>(position - objects.Position(index));
+}
+
+int CContMinesweeper::CheckForObject(CContObjectPool &objects, double size)
 {
-	SVector2D<double> DistToObject = m_vPosition - objects[m_iClosestMine]->getPosition();
-		
-	if (Vec2DLength<double>(DistToObject) < (size + 5))
+	if (DistanceToClosest(objects, m_vPosition, m_iClosestMine, m_dClosestMineDistance) < (size + 5))
 	{
 			return m_iClosestMine;
 	}
 
-	DistToObject = m_vPosition - objects[m_iClosestRock]->getPosition();
-		
-	if (Vec2DLength<double>(DistToObject) < (size + 5))
+	if (DistanceToClosest(objects, m_vPosition, m_iClosestRock, m_dClosestRockDistance) < (size + 5))
 	{
 			return m_iClosestRock;
 	}
 
-	DistToObject = m_vPosition - objects[m_iClosestSupermine]->getPosition();
-		
-	if (Vec2DLength<double>(DistToObject) < (size + 5))
+	if (DistanceToClosest(objects, m_vPosition, m_iClosestSupermine, m_dClosestSupermineDistance) < (size + 5))
 	{
 			return m_iClosestSupermine;
 	}
@@ -17,9 +17,12 @@
 #include "SVector2D.h"
 #include "CParams.h"
 #include "CContCollisionObject.h"
+#include "CSpatialGrid.h"
 #include "CMinesweeper.h"
 #define MAX_TURNING_RATE_IN_DEGREES 2.0
 #define MAX_SPEED_IN_PIXELS 0.5
+//closest distance stored for a type with no live objects
+#define NO_OBJECT_DISTANCE 99999
 using namespace std;
 
 
@@ -37,29 +40,49 @@ private:
 	double			m_dRotation;
 
 	double			m_dSpeed;
-	//sets the internal closest object variables for the 3 types of objects
-	void GetClosestObjects(vector<CContCollisionObject*> &objects);
+
+	//distance to the closest object of each type, as of the last GetClosestObjects
+	double			m_dClosestMineDistance;
+	double			m_dClosestRockDistance;
+	double			m_dClosestSupermineDistance;
 public:
+	//sets the internal closest object variables for the 3 types of objects
+	void GetClosestObjects(CContObjectPool &objects, const CSpatialGrid &grid);
+
+	//false if the objects changed so far (flagged in changed: moved or
+	//destroyed) cannot change which objects GetClosestObjects finds for the
+	//sweeper where it stands. movedTypes has a bit per type with a changed
+	//object that is still alive
+	bool ClosestMayChange(CContObjectPool &objects, const CSpatialGrid &grid,
+						  const vector<uint8_t> &changed, int movedTypes) const;
 	
 	void setSpeed(double speed);
 	double getSpeed() const;
 	SVector2D<double> getLookAt(void) const;
-	CContMinesweeper();
+	CContMinesweeper(const CRandomStream &rng);
 	
 	//updates the information from the sweepers enviroment
-	bool			Update(vector<CContCollisionObject*> &objects);
+	bool			Update(CContObjectPool &objects, const CSpatialGrid &grid);
 
 	//used to transform the sweepers vertices prior to rendering
 	void			WorldTransform(vector<SPoint> &sweeper);
 
-	//checks to see if the minesweeper has 'collected' a mine
-	int       CheckForObject(vector<CContCollisionObject*> &objects, double size);
+	//checks to see if the minesweeper has 'collected' a mine, using the
+	//distances of the last GetClosestObjects
+	int       CheckForObject(CContObjectPool &objects, double size);
 
 	void			Reset();
+
+	//puts the sweeper at a given position, rotation and speed (in pixels),
+	//alive with no mines - how a replay lays out a recorded episode
+	void			Place(SVector2D<double> position, double rotation, double speed);
   
 
 	//-------------------accessor functions
 	SVector2D<double>	Position()const{return m_vPosition;}
+
+	double			getRotation()const{return m_dRotation;}
+	void			setRotation(double rotation){m_dRotation = rotation;}
 	
 	//turs towards/away from the specified point at a specified rate
 	void turn(SPoint pt, double rate_factor, bool towards = true);
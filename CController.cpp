@@ -1,4 +1,6 @@
 #include "CController.h"
+#include <string.h>
+#include <iostream>
 
 //---------------------------------------constructor---------------------
 //
@@ -15,27 +17,43 @@ void CController::Initialize()
 	InitializeSuperMines();
 	InitializeRocks();
 
+	//the first episode starts from the scenario bank's layout, if there is one
+	if (CParams::bUseScenarios && !UseScenarioBank(CParams::sScenarioFilename.c_str()))
+	{
+		std::cout << "Cannot use the scenario bank " << CParams::sScenarioFilename
+				  << ", the layouts will be random" << std::endl;
+	}
+
 	//initialize the learning algoritm in child classes
 	InitializeLearningAlgorithm();
 }
 
 CController::CController(HWND hwndMain): m_NumSweepers(CParams::iNumSweepers),
-										                     m_bFastRender(false),
-										                     m_iTicks(0),
 										                     m_NumMines(CParams::iNumMines),
 															 m_NumSuperMines(CParams::iNumSuperMines),
 															 m_NumRocks(CParams::iNumRocks),
+															 m_Rng(CRandomService::Stream(CRandomService::Environment, 0)),
 										                     m_hwndMain(hwndMain),
+										                     m_bFastRender(false),
+										                     m_iTicks(0),
 										                     m_iIterations(0),
                                          cxClient(CParams::WindowWidth),
-                                         cyClient(CParams::WindowHeight)
+                                         cyClient(CParams::WindowHeight),
+										 m_pRecorder(NULL),
+										 m_pPlayer(NULL),
+										 m_iReplayEpisode(0),
+										 m_bReplayMatched(true),
+										 m_pScenarios(NULL),
+										 m_iScenarioLayout(-1)
 {
+#ifdef _WIN32
 	//create a pen for the graph drawing
 	m_BluePen  = CreatePen(PS_SOLID, 1, RGB(0, 0, 255));
 	m_RedPen   = CreatePen(PS_SOLID, 1, RGB(255, 0, 0));
 	m_GreenPen = CreatePen(PS_SOLID, 1, RGB(0, 150, 0));
 
 	m_OldPen	= NULL;
+#endif
 
 	//fill the vertex buffers
 	for (int i=0; i<NumSweeperVerts; ++i)
@@ -48,6 +66,8 @@ CController::CController(HWND hwndMain): m_NumSweepers(CParams::iNumSweepers),
 		m_MineVB.push_back(mine[i]);
 	}
 
+	m_Workers.Start(CParams::iStepThreads);
+
 }
 
 
@@ -56,12 +76,209 @@ CController::CController(HWND hwndMain): m_NumSweepers(CParams::iNumSweepers),
 //--------------------------------------------------------------------------------------
 CController::~CController()
 {
+	delete m_pRecorder;
+	delete m_pPlayer;
+	delete m_pScenarios;
+
+#ifdef _WIN32
 	DeleteObject(m_BluePen);
 	DeleteObject(m_RedPen);
 	DeleteObject(m_GreenPen);
 	DeleteObject(m_OldPen);
+#endif
+}
+
+//--------------------------StartRecording-------------------------------
+//
+//	the header carries what a replay needs to build the same world
+//
+//------------------------------------------------------------------------
+bool CController::StartRecording(const char* szFileName)
+{
+	if (m_pPlayer || TraceWorldType() < 0) return false;
+
+	STraceHeader header;
+	memset(&header, 0, sizeof(header));
+
+	header.world = (uint32_t)TraceWorldType();
+	header.seed = (uint32_t)CParams::iRandomSeed;
+	header.numSweepers = m_NumSweepers;
+	header.numMines = m_NumMines;
+	header.numSuperMines = m_NumSuperMines;
+	header.numRocks = m_NumRocks;
+	header.numTicks = CParams::iNumTicks;
+	header.windowWidth = CParams::WindowWidth;
+	header.windowHeight = CParams::WindowHeight;
+	header.gridCellDim = CParams::iGridCellDim;
+	header.worldCellsX = CParams::iWorldCellsX;
+	header.worldCellsY = CParams::iWorldCellsY;
+
+	CTraceWriter* recorder = new CTraceWriter;
+
+	if (!recorder->Open(szFileName, header))
+	{
+		delete recorder;
+
+		return false;
+	}
+
+	delete m_pRecorder;
+	m_pRecorder = recorder;
+
+	//an episode that is already under way is left out
+	if (m_iTicks == 0) BeginTraceEpisode();
+
+	return true;
+}
+
+void CController::StopRecording(void)
+{
+	delete m_pRecorder;
+	m_pRecorder = NULL;
 }
 
+//---------------------------StartReplay---------------------------------
+//
+//	the controller must have been built (and initialized) for the trace's
+//	world, so that there are as many objects and sweepers to lay out
+//
+//------------------------------------------------------------------------
+bool CController::StartReplay(CTraceReader* reader, int episode)
+{
+	if (m_pRecorder || !reader->Seek(episode)) return false;
+
+	m_pPlayer = reader;
+	m_iReplayEpisode = episode;
+
+	if (!ReplayLayout())
+	{
+		m_pPlayer = NULL;
+
+		return false;
+	}
+
+	m_iTicks = 0;
+	m_bReplayMatched = true;
+
+	return true;
+}
+
+//--------------------------UseScenarioBank-------------------------------
+//
+//	a bank fits when it was made for this kind of world, at this size and
+//	with these numbers of objects and sweepers
+//
+//------------------------------------------------------------------------
+bool CController::UseScenarioBank(const char* szFileName)
+{
+	CScenarioBank* bank = new CScenarioBank;
+
+	if (!bank->Open(szFileName))
+	{
+		delete bank;
+
+		return false;
+	}
+
+	const SScenarioHeader &header = bank->Header();
+
+	//the continuous world is the window
+	int world = TraceWorldType();
+	int width = world == DiscreteTrace ? CParams::WorldWidth : cxClient;
+	int height = world == DiscreteTrace ? CParams::WorldHeight : cyClient;
+
+	if ((int)header.world != world || (int)header.numSweepers != m_NumSweepers ||
+		(int)header.numMines != m_NumMines || (int)header.numSuperMines != m_NumSuperMines ||
+		(int)header.numRocks != m_NumRocks || (int)header.worldWidth != width ||
+		(int)header.worldHeight != height ||
+		(world == DiscreteTrace && (int)header.gridCellDim != CParams::iGridCellDim))
+	{
+		delete bank;
+
+		return false;
+	}
+
+	delete m_pScenarios;
+	m_pScenarios = bank;
+	m_iScenarioLayout = -1;
+
+	std::cout << "Scenario bank: " << bank->NumLayouts() << " layouts from " << szFileName << std::endl;
+
+	//an episode that is already under way keeps its world
+	if (m_iTicks == 0) NextScenario();
+
+	return true;
+}
+
+bool CController::NextScenario(void)
+{
+	if (!m_pScenarios) return false;
+
+	int layout = m_iIterations % m_pScenarios->NumLayouts();
+
+	ApplyScenario(layout);
+	m_iScenarioLayout = layout;
+
+	return true;
+}
+
+void CController::EndTraceEpisode(uint deaths, double minesGathered)
+{
+	if (m_pRecorder && m_pRecorder->EpisodeOpen())
+	{
+		if (!m_pRecorder->EndEpisode(deaths, minesGathered))
+		{
+			std::cout << "Could not write the episode trace, recording stopped" << std::endl;
+			StopRecording();
+		}
+	}
+
+	if (m_pPlayer)
+	{
+		uint recordedDeaths;
+		double recordedMines;
+
+		bool matched = m_pPlayer->Summary(recordedDeaths, recordedMines) &&
+					   recordedDeaths == deaths && recordedMines == minesGathered;
+
+		std::cout << "Replay of iteration " << m_pPlayer->Iteration(m_iReplayEpisode) << ": "
+				  << deaths << " deaths, " << minesGathered << " mines";
+
+		if (matched)
+			std::cout << " - matches the recording" << std::endl;
+		else
+			std::cout << " - DIFFERS from the recording (" << recordedDeaths << " deaths, "
+					  << recordedMines << " mines)" << std::endl;
+
+		m_bReplayMatched = m_bReplayMatched && matched;
+	}
+}
+
+bool CController::RewindReplay(void)
+{
+	if (!m_pPlayer) return false;
+
+	if (m_pPlayer->Seek(m_iReplayEpisode) && ReplayLayout()) return true;
+
+	//the trace cannot be laid out again, so carry on as a live world
+	std::cout << "Could not rewind the replayed episode, replay stopped" << std::endl;
+
+	delete m_pPlayer;
+	m_pPlayer = NULL;
+
+	return false;
+}
+
+void CController::BeginTraceEpisode(void)
+{
+	if (!m_pRecorder) return;
+
+	m_pRecorder->BeginEpisode(m_iIterations);
+	RecordLayout();
+}
+
+#ifdef _WIN32
+
 //--------------------------PlotStats-------------------------------------
 //
 //  Given a surface to draw on this function displays stats and a crude
@@ -117,3 +334,4 @@ void CController::PlotStats(HDC surface)
     SelectObject(surface, m_OldPen);
 }
 
+#endif
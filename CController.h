@@ -14,13 +14,17 @@
 #include <sstream>
 #include <string>
 #include <fstream>
-#include <windows.h>
+#include "Platform.h"
 #include "utils.h"
 #include "C2DMatrix.h"
 #include "SVector2D.h"
 #include "CParams.h"
 #include "CCollisionObject.h"
 #include "CMinesweeper.h"
+#include "CRandom.h"
+#include "CTrace.h"
+#include "CScenario.h"
+#include "CThreadPool.h"
 #include <algorithm>
 //these hold the geometry of the sweepers and the mines
 const int	 NumSweeperVerts = 16;
@@ -52,6 +56,10 @@ const SPoint mine[NumMineVerts] = {SPoint(-1, -1),
                                    SPoint(1, 1),
                                    SPoint(1, -1)};
 
+//sweepers per thread below which a tick's steps are not split up - the
+//hand-off costs more than stepping a few hundred sweepers
+const uint MIN_STEP_CHUNK = 1024;
+
 class CController
 {
 
@@ -64,6 +72,12 @@ protected:
 
 	int							totalMinesCollected;
 
+	//random stream for the environment (object layout and respawns)
+	CRandomStream				m_Rng;
+
+	//threads the sweepers of a tick are stepped on (iStepThreads)
+	CThreadPool					m_Workers;
+
 	//vertex buffer for the sweeper shape's vertices
 	vector<SPoint>		   m_SweeperVB;
 
@@ -84,11 +98,13 @@ protected:
 	vector<double>			m_vecMines;
 
 
+#ifdef _WIN32
 	//pens we use for the stats
 	HPEN				m_RedPen;
 	HPEN				m_BluePen;
 	HPEN				m_GreenPen;
 	HPEN				m_OldPen;
+#endif
 	
 	//handle to the application window
 	HWND				m_hwndMain;
@@ -105,9 +121,50 @@ protected:
   //window dimensions
   int         cxClient, cyClient;
 
+	//episode trace being recorded, NULL when not recording
+	CTraceWriter*		m_pRecorder;
+
+	//trace being played back and which of its episodes, NULL for a live controller
+	CTraceReader*		m_pPlayer;
+	int					m_iReplayEpisode;
+	bool				m_bReplayMatched;
+
+	//the kind of trace the controller records (a TraceWorld), -1 if it cannot
+	virtual int			TraceWorldType(void)const{return -1;}
+
+	//writes the world as it is at the start of an episode into the recorder
+	virtual void		RecordLayout(void){}
+
+	//puts the world back the way the player's current episode starts
+	virtual bool		ReplayLayout(void){return false;}
+
+	//rollover bookkeeping shared by the worlds: closes the recorded episode or
+	//checks the replayed one against what was recorded...
+	void				EndTraceEpisode(uint deaths, double minesGathered);
+
+	//...then either rewinds the replay (true - the world needs no other reset)
+	//or, after the world has been reset, starts recording the next episode
+	bool				RewindReplay(void);
+	void				BeginTraceEpisode(void);
+
+	//bank of layouts the episodes start from (bUseScenarios), NULL for random
+	//worlds, and the layout that was laid out last (-1 for none)
+	CScenarioBank*		m_pScenarios;
+	int					m_iScenarioLayout;
+
+	//lays out a layout of the bank - objects and sweeper spawns - in place of
+	//a reset. The bank has been checked to match the world
+	virtual void		ApplyScenario(int /*layout*/){}
+
+	//rollover: lays out the bank's layout for the new iteration (true), or
+	//returns false if there is no bank and the world needs its random reset
+	bool				NextScenario(void);
+
+#ifdef _WIN32
   //this function plots a graph of the average and best MinesGathered
   //over the course of a run
   void   PlotStats(HDC surface);
+#endif
 
 public:
 
@@ -133,18 +190,62 @@ public:
 	}
 
 	void Initialize();
+#ifdef _WIN32
 	virtual void Render(HDC surface) = 0;
+#endif
 	virtual bool Update() = 0;
 	virtual void InitializeLearningAlgorithm(void) = 0;
 	virtual void InitializeSweepers(void) = 0;
 	virtual void InitializeMines(void) = 0;
 	virtual void InitializeSuperMines(void) = 0;
 	virtual void InitializeRocks(void) = 0;
+
+	//saves what has been learned so far to the checkpoint file, returns
+	//false if the controller has nothing to save or the save failed
+	virtual bool SaveCheckpoint(void){return false;}
+
+	//switches between learning and running the frozen greedy policy, for
+	//controllers that can compile one
+	virtual void EvaluationToggle(void){}
+
+	//moves the window over a world bigger than it, by a number of cells, for
+	//controllers whose world can be
+	virtual void ScrollView(int /*dx*/, int /*dy*/){}
+
+	//records every episode to a trace file, from the current one if it has
+	//not started yet and otherwise from the next. Returns false if the
+	//controller cannot record or the file cannot be written
+	bool		StartRecording(const char* szFileName);
+	void		StopRecording(void);
+
+	//plays an episode of a trace (over and over) instead of simulating: the
+	//world is laid out as recorded and the sweepers repeat the recorded
+	//actions. Takes the reader over, unless it returns false - the episode
+	//cannot be laid out and the controller stays live
+	bool		StartReplay(CTraceReader* reader, int episode);
+
+	//starts every episode from the next layout of a scenario bank, from the
+	//current one if it has not started yet. Returns false (and the world
+	//stays random) if the bank cannot be read or was made for another world
+	bool		UseScenarioBank(const char* szFileName);
+
 	//accessor methods
 	bool		FastRender()const	  {return m_bFastRender;}
 	void		FastRender(bool arg){m_bFastRender = arg;}
 	void		FastRenderToggle()  {m_bFastRender = !m_bFastRender;}
 
+	int			Iterations()const	{return m_iIterations;}
+	bool		Recording()const	{return m_pRecorder != NULL;}
+	const CTraceWriter*	Recorder()const	{return m_pRecorder;}
+	bool		Replaying()const	{return m_pPlayer != NULL;}
+	bool		ReplayMatched()const{return m_bReplayMatched;}
+	int			NumSweepers()const	{return m_NumSweepers;}
+
+	//per iteration stats
+	const vector<double>&	AvMinesGathered()const	{return m_vecAvMinesGathered;}
+	const vector<double>&	MostMinesGathered()const{return m_vecMostMinesGathered;}
+	const vector<double>&	Deaths()const			{return m_vecDeaths;}
+
 };
 
 
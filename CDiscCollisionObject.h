@@ -1,19 +1,11 @@
 #ifndef CDiscCOLLISIONOBJECT_H
 #define CDiscCOLLISIONOBJECT_H
 #include "SVector2D.h"
-#include "CCollisionObject.h"
-class CDiscCollisionObject: public CCollisionObject
-{
-public:
-	CDiscCollisionObject();
-	CDiscCollisionObject(ObjectType objectType, SVector2D<int> position);
-	virtual ~CDiscCollisionObject();
+#include "CObjectPool.h"
 
-	void setPosition(SVector2D<int> position);
-	SVector2D<int> getPosition() const;
-	
-private:
-	SVector2D<int> * m_vPosition;
-};
+//discrete objects sit on grid positions; each one is a slot of the
+//controller's object pool
+typedef CObjectPool<int> CDiscObjectPool;
+typedef CObjectRef<int> CDiscCollisionObject;
 
-#endif
\ No newline at end of file
+#endif
@@ -1,36 +1,356 @@
 #include "CDiscController.h"
 #include <iostream>
-#include <fstream>
+#include <algorithm>
 
 
 CDiscController::CDiscController(HWND hwndMain):
-	CController(hwndMain)
+	CController(hwndMain),
+	m_iGridX(CParams::WorldWidth / CParams::iGridCellDim + 1),
+	m_iGridY(CParams::WorldHeight / CParams::iGridCellDim + 1),
+	m_bBitboards(CParams::bBitboardWorld || m_iGridX * m_iGridY > MAX_CHAIN_INDEX_CELLS),
+	m_bFieldsStale(true),
+	m_pPolicy(NULL),
+	m_iViewX(0),
+	m_iViewY(0)
 {
-	assert(CParams::WindowHeight % CParams::iGridCellDim == 0);
-	assert(CParams::WindowWidth % CParams::iGridCellDim == 0);
+	assert(CParams::WorldHeight % CParams::iGridCellDim == 0);
+	assert(CParams::WorldWidth % CParams::iGridCellDim == 0);
 }
 
 CDiscController::~CDiscController(void)
 {
-	for (auto i = m_vecSweepers.begin(); i != m_vecSweepers.end(); ++i)
-		delete *i;
-	for (auto i = m_vecObjects.begin(); i != m_vecObjects.end(); ++i)
-		delete *i;
 }
 
 void CDiscController::InitializeLearningAlgorithm(void)
 {
 	/**
 	This is the basic discrete environment so there are no learning algorithms
-	to initialize yet...
+	to initialize yet... but every object has been placed by now, so index them
 	*/
+	BuildOccupancyIndex();
+}
+
+//-------------------------------BuildOccupancyIndex-----------------------
+//
+//	chains the objects of every cell together. Objects are visited in
+//	reverse so that each chain ends up in ascending index order
+//
+//-------------------------------------------------------------------------
+void CDiscController::BuildOccupancyIndex(void)
+{
+	int cells = m_iGridX * m_iGridY;
+
+	if (m_bBitboards)
+	{
+		m_vecCellObjects.resize(m_vecObjects.size());
+
+		for (int type = 0; type < CCollisionObject::NUM_OBJECT_TYPES; ++type)
+		{
+			m_Initial[type].Allocate(cells);
+			m_Live[type].Allocate(cells);
+		}
+		m_Visited.Allocate(cells);
+
+		for (int i = 0; i < (int)m_vecObjects.size(); ++i)
+		{
+			int cell = CellAt(m_vecObjects[i].getPosition());
+
+			m_vecCellObjects[i] = ((uint64_t)cell << 32) | (uint32_t)i;
+			m_Initial[m_vecObjects[i].getType()].Set(cell);
+
+			if (!m_vecObjects[i].isDead()) m_Live[m_vecObjects[i].getType()].Set(cell);
+		}
+
+		std::sort(m_vecCellObjects.begin(), m_vecCellObjects.end());
+
+		int words = (cells + 63) / 64;
+		size_t entry = 0;
+
+		m_vecWordStart.resize(words + 1);
+
+		for (int w = 0; w <= words; ++w)
+		{
+			while (entry < m_vecCellObjects.size() && (int)(m_vecCellObjects[entry] >> 38) < w) ++entry;
+
+			m_vecWordStart[w] = (uint32_t)entry;
+		}
+
+		//none of the per cell chains are needed
+		vector<int>().swap(m_vecCellFirst);
+		vector<int>().swap(m_vecTypeFirst);
+		vector<int>().swap(m_vecTypeHead);
+		vector<int>().swap(m_vecObjectNext);
+
+		m_bFieldsStale = true;
+
+		return;
+	}
+
+	m_vecCellFirst.assign(cells, -1);
+	m_vecTypeFirst.assign(CCollisionObject::NUM_OBJECT_TYPES * cells, -1);
+	m_vecObjectNext.assign(m_vecObjects.size(), -1);
+
+	for (int i = (int)m_vecObjects.size() - 1; i >= 0; --i)
+	{
+		int cell = CellAt(m_vecObjects[i].getPosition());
+		int slot = m_vecObjects[i].getType() * cells + cell;
+
+		m_vecObjectNext[i] = m_vecTypeFirst[slot];
+		m_vecTypeFirst[slot] = i;
+		m_vecCellFirst[cell] = i;
+	}
+
+	m_vecTypeHead = m_vecTypeFirst;
+
+	//skip anything that starts out dead
+	for (uint i = 0; i < m_vecTypeHead.size(); ++i)
+	{
+		while (m_vecTypeHead[i] != -1 && m_vecObjects[m_vecTypeHead[i]].isDead())
+			m_vecTypeHead[i] = m_vecObjectNext[m_vecTypeHead[i]];
+	}
+
+	m_bFieldsStale = true;
+}
+
+//-------------------------------BuildDistanceFields-----------------------
+//
+//	the fields cover the cells the sweepers wrap around on - objects placed
+//	on the far edge row/column can never be reached, so they are left out
+//
+//-------------------------------------------------------------------------
+void CDiscController::BuildDistanceFields(void)
+{
+	int spanX = CParams::WorldWidth / CParams::iGridCellDim;
+	int spanY = CParams::WorldHeight / CParams::iGridCellDim;
+	int cells = m_iGridX * m_iGridY;
+
+	m_vecFieldSources.resize(spanX * spanY);
+
+	for (int type = 0; type < CCollisionObject::NUM_OBJECT_TYPES; ++type)
+	{
+		if (m_Fields[type].SpanX() != spanX || m_Fields[type].SpanY() != spanY)
+			m_Fields[type].Allocate(spanX, spanY);
+
+		if (m_bBitboards)
+		{
+			//only the cells with a live object need looking up
+			std::fill(m_vecFieldSources.begin(), m_vecFieldSources.end(), -1);
+
+			for (int cell = m_Live[type].NextSet(0); cell != -1; cell = m_Live[type].NextSet(cell + 1))
+			{
+				int x = cell / m_iGridY;
+				int y = cell % m_iGridY;
+
+				if (x < spanX && y < spanY) m_vecFieldSources[x * spanY + y] = FirstLiveObject(type, cell);
+			}
+		}
+		else
+		{
+			for (int x = 0; x < spanX; ++x)
+			{
+				for (int y = 0; y < spanY; ++y)
+				{
+					m_vecFieldSources[x * spanY + y] = m_vecTypeHead[type * cells + CellIndex(x, y)];
+				}
+			}
+		}
+
+		m_Fields[type].Rebuild(m_vecFieldSources);
+	}
+
+	m_bFieldsStale = false;
+}
+
+void CDiscController::KillObject(int index)
+{
+	m_vecObjects[index].die();
+
+	int cell = CellAt(m_vecObjects[index].getPosition());
+
+	//the next live object of the same type on the cell, if any
+	int next;
+
+	if (m_bBitboards)
+	{
+		next = FirstLiveObject(m_vecObjects[index].getType(), cell);
+
+		if (next == -1) m_Live[m_vecObjects[index].getType()].Clear(cell);
+	}
+	else
+	{
+		int slot = m_vecObjects[index].getType() * m_iGridX * m_iGridY + cell;
+
+		//collisions always take the head of a chain, so this loop normally runs once
+		while (m_vecTypeHead[slot] != -1 && m_vecObjects[m_vecTypeHead[slot]].isDead())
+			m_vecTypeHead[slot] = m_vecObjectNext[m_vecTypeHead[slot]];
+
+		next = m_vecTypeHead[slot];
+	}
+
+	if (m_bFieldsStale) return;
+
+	//the next object on the cell (if any) takes over as the nearest source
+	int x = m_vecObjects[index].getPosition().x / CParams::iGridCellDim;
+	int y = m_vecObjects[index].getPosition().y / CParams::iGridCellDim;
+	CDistanceField &field = m_Fields[m_vecObjects[index].getType()];
+
+	if (x < field.SpanX() && y < field.SpanY() && field.Nearest(x, y) == index)
+		field.RemoveSource(x, y, next);
+}
+
+void CDiscController::ResetObjects(void)
+{
+	m_vecObjects.ReviveAll();
+
+	if (m_bBitboards)
+	{
+		//every object is back on the cell it was placed on, and nothing has been visited
+		for (int type = 0; type < CCollisionObject::NUM_OBJECT_TYPES; ++type)
+		{
+			m_Live[type].CopyFrom(m_Initial[type]);
+		}
+		m_Visited.Reset();
+	}
+	else
+	{
+		//everything is alive again, so every chain starts from its first object
+		m_vecTypeHead = m_vecTypeFirst;
+	}
+
+	//all the sources are back at once - one rebuild (on the next query) is cheaper than
+	//adding them one by one
+	m_bFieldsStale = true;
+}
+
+//-------------------------------CheckForObject----------------------------
+//
+//	O(1) collision test against the occupancy index: only the heads of the
+//	three chains of the sweeper's own cell need to be looked at
+//
+//-------------------------------------------------------------------------
+int CDiscController::CheckForObject(int cell) const
+{
+	//most cells are empty, and the bitboards say so without touching the objects
+	if (m_bBitboards)
+	{
+		if (m_Live[CCollisionObject::Mine].Test(cell)) return FirstLiveObject(CCollisionObject::Mine, cell);
+		if (m_Live[CCollisionObject::Rock].Test(cell)) return FirstLiveObject(CCollisionObject::Rock, cell);
+		if (m_Live[CCollisionObject::SuperMine].Test(cell)) return FirstLiveObject(CCollisionObject::SuperMine, cell);
+
+		return -1;
+	}
+
+	int cells = m_iGridX * m_iGridY;
+
+	if (m_vecTypeHead[CCollisionObject::Mine * cells + cell] != -1)
+		return m_vecTypeHead[CCollisionObject::Mine * cells + cell];
+
+	if (m_vecTypeHead[CCollisionObject::Rock * cells + cell] != -1)
+		return m_vecTypeHead[CCollisionObject::Rock * cells + cell];
+
+	return m_vecTypeHead[CCollisionObject::SuperMine * cells + cell];
+}
+
+//-------------------------------FirstLiveObject----------------------------
+//
+//	binary search for the cell's run of m_vecCellObjects, within the entries
+//	of its board word - only called for cells whose bit is set, and a run is
+//	nearly always a single object
+//
+//-------------------------------------------------------------------------
+int CDiscController::FirstLiveObject(int type, int cell) const
+{
+	const uint64_t* last = &m_vecCellObjects[0] + m_vecWordStart[(cell >> 6) + 1];
+	const uint64_t* entry =
+		std::lower_bound(&m_vecCellObjects[0] + m_vecWordStart[cell >> 6], last, (uint64_t)cell << 32);
+
+	for (; entry != last && (int)(*entry >> 32) == cell; ++entry)
+	{
+		int index = (int)(uint32_t)*entry;
+
+		if (m_vecObjects.Type(index) == type && m_vecObjects.Alive(index)) return index;
+	}
+
+	return -1;
+}
+
+int CDiscController::FirstObjectInCell(int cell) const
+{
+	if (!m_bBitboards) return m_vecCellFirst[cell];
+
+	if (!m_Initial[CCollisionObject::Mine].Test(cell) &&
+		!m_Initial[CCollisionObject::Rock].Test(cell) &&
+		!m_Initial[CCollisionObject::SuperMine].Test(cell))
+	{
+		return -1;
+	}
+
+	return (int)(uint32_t)*std::lower_bound(&m_vecCellObjects[0] + m_vecWordStart[cell >> 6],
+											 &m_vecCellObjects[0] + m_vecWordStart[(cell >> 6) + 1],
+											 (uint64_t)cell << 32);
+}
+
+size_t CDiscController::WorldBytes(void) const
+{
+	size_t bytes = m_vecObjects.Bytes() +
+				   (m_vecCellFirst.size() + m_vecTypeFirst.size() + m_vecTypeHead.size() + m_vecObjectNext.size()) * sizeof(int) +
+				   m_vecCellObjects.size() * sizeof(uint64_t) + m_vecWordStart.size() * sizeof(uint32_t) +
+				   m_Visited.Bytes();
+
+	for (int type = 0; type < CCollisionObject::NUM_OBJECT_TYPES; ++type)
+	{
+		bytes += m_Live[type].Bytes() + m_Initial[type].Bytes() + m_Fields[type].Bytes();
+	}
+
+	return bytes;
+}
+
+//-------------------------------ScrollView---------------------------------
+//
+//	the view stays inside the world, far edge cells included
+//
+//-------------------------------------------------------------------------
+void CDiscController::ScrollView(int dx, int dy)
+{
+	int maxX = std::max(0, m_iGridX * CParams::iGridCellDim - CParams::WindowWidth);
+	int maxY = std::max(0, m_iGridY * CParams::iGridCellDim - CParams::WindowHeight);
+
+	m_iViewX = std::min(std::max(m_iViewX + dx * CParams::iGridCellDim, 0), maxX);
+	m_iViewY = std::min(std::max(m_iViewY + dy * CParams::iGridCellDim, 0), maxY);
+}
+
+//-------------------------------LocalView----------------------------------
+//
+//	the block wraps around the world edges the same way the sweepers do
+//	(they never stand on the far edge cells, so neither does the block)
+//
+//-------------------------------------------------------------------------
+uint32_t CDiscController::LocalView(int x, int y) const
+{
+	int spanX = CParams::WorldWidth / CParams::iGridCellDim;
+	int spanY = CParams::WorldHeight / CParams::iGridCellDim;
+
+	uint32_t view = 0;
+
+	for (int dx = -1; dx <= 1; ++dx)
+	{
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			int object = CheckForObject(CellIndex((x + dx + spanX) % spanX, (y + dy + spanY) % spanY));
+			uint32_t type = object == -1 ? 0 : 1 + m_vecObjects.Type(object);
+
+			view = (view << 2) | type;
+		}
+	}
+
+	return view;
 }
 
 void CDiscController::InitializeSweepers(void)
 {
 	for (int i=0; i<m_NumSweepers; ++i)
 	{
-		m_vecSweepers.push_back(new CDiscMinesweeper());
+		m_vecSweepers.Add(CRandomService::Stream(CRandomService::Sweeper, i));
 	}
 }
 
@@ -38,10 +358,9 @@ void CDiscController::InitializeMines(void)
 {
 	for (int i=0; i<m_NumMines; ++i)
 	{
-		int x = RandInt(0,CParams::WindowWidth/CParams::iGridCellDim)*CParams::iGridCellDim;
-		int y = RandInt(0,CParams::WindowHeight/CParams::iGridCellDim)*CParams::iGridCellDim;
-		m_vecObjects.push_back(new CDiscCollisionObject(CCollisionObject::Mine, 
-								 SVector2D<int>(x,y)));
+		int x = m_Rng.RandInt(0,CParams::WorldWidth/CParams::iGridCellDim)*CParams::iGridCellDim;
+		int y = m_Rng.RandInt(0,CParams::WorldHeight/CParams::iGridCellDim)*CParams::iGridCellDim;
+		m_vecObjects.Add(CCollisionObject::Mine, SVector2D<int>(x,y));
 	}
 }
 
@@ -49,9 +368,9 @@ void CDiscController::InitializeSuperMines(void)
 {
 	for (int i=0; i<m_NumSuperMines; ++i)
 	{
-		m_vecObjects.push_back(new CDiscCollisionObject(CCollisionObject::SuperMine, 
-								 SVector2D<int>(RandInt(0,CParams::WindowWidth/CParams::iGridCellDim)*CParams::iGridCellDim, 
-					             RandInt(0,CParams::WindowHeight/CParams::iGridCellDim)*CParams::iGridCellDim)));
+		m_vecObjects.Add(CCollisionObject::SuperMine, 
+						 SVector2D<int>(m_Rng.RandInt(0,CParams::WorldWidth/CParams::iGridCellDim)*CParams::iGridCellDim, 
+					     m_Rng.RandInt(0,CParams::WorldHeight/CParams::iGridCellDim)*CParams::iGridCellDim));
 	}
 }
 
@@ -59,9 +378,9 @@ void CDiscController::InitializeRocks(void)
 {
 	for (int i=0; i<m_NumRocks; ++i)
 	{
-		m_vecObjects.push_back(new CDiscCollisionObject(CCollisionObject::Rock, 
-								 SVector2D<int>(RandInt(0,CParams::WindowWidth/CParams::iGridCellDim)*CParams::iGridCellDim, 
-					             RandInt(0,CParams::WindowHeight/CParams::iGridCellDim)*CParams::iGridCellDim)));
+		m_vecObjects.Add(CCollisionObject::Rock, 
+						 SVector2D<int>(m_Rng.RandInt(0,CParams::WorldWidth/CParams::iGridCellDim)*CParams::iGridCellDim, 
+					     m_Rng.RandInt(0,CParams::WorldHeight/CParams::iGridCellDim)*CParams::iGridCellDim));
 	}
 }
 
@@ -78,54 +397,108 @@ bool CDiscController::Update()
 	//information from its surroundings. The output from the learning algorithm is obtained
 	//and the sweeper is moved. If it encounters a mine its MinesGathered is
 	//updated appropriately,
+
+	//a replayed episode ends where the recorded one did (this also reads past
+	//the end of the tick list when it runs the full length)
+	if (m_pPlayer && !m_pPlayer->BeginTick())
+	{
+		m_iTicks = CParams::iNumTicks;
+	}
+
 	if (m_iTicks++ < CParams::iNumTicks)
 	{
-		for (int i=0; i<m_NumSweepers; ++i)
+		const vector<int> &active = m_vecSweepers.Active();
+
+		//a replay repeats the recorded moves, in evaluation mode the compiled policy
+		//picks the direction
+		if (m_pPlayer)
+		{
+			ReplayTick();
+		}
+		else if (m_pPolicy)
 		{
-			if ((m_vecSweepers[i])->isDead()) continue;
-			//update the position
-			if (!(m_vecSweepers[i])->Update(m_vecObjects))
+			auto policyStep = [&](uint begin, uint end)
 			{
-				//error in processing the learning algorithm
-				MessageBox(m_hwndMain, "An error occured while processing!", "Error", MB_OK);
+				for (uint k=begin; k<end; ++k)
+				{
+					int i = active[k];
+					int cell = CellAt(m_vecSweepers.Position(i));
+					m_vecSweepers.SetRotation(i, (ROTATION_DIRECTION)m_pPolicy->Action(m_pPolicy->MapOf(i), cell));
+				}
+			};
+
+			m_Workers.ParallelFor(active.size(), MIN_STEP_CHUNK, policyStep);
+		}
+
+		if (m_pRecorder && m_pRecorder->EpisodeOpen()) RecordTick();
+
+		//update the positions, all in one pass
+		auto moveStep = [&](uint begin, uint end)
+		{
+			m_vecSweepers.Move(begin, end);
+		};
+
+		m_Workers.ParallelFor(m_vecSweepers.size(), MIN_STEP_CHUNK, moveStep);
 
-				return false;
+		//what each sweeper has run into, as the world stood at the start of the tick.
+		//The sweepers only read the world here, so this can be split up
+		m_vecStepHits.resize(active.size());
+
+		auto hitStep = [&](uint begin, uint end)
+		{
+			for (uint k=begin; k<end; ++k)
+			{
+				m_vecStepHits[k] = CheckForObject(CellAt(m_vecSweepers.Position(active[k])));
 			}
-				
-			//see if it's found a mine
-			int GrabHit = ((m_vecSweepers[i])->CheckForObject(m_vecObjects,
-													CParams::dMineScale));
+		};
+
+		m_Workers.ParallelFor(active.size(), MIN_STEP_CHUNK, hitStep);
+
+		//then the collisions take effect in sweeper order
+		for (uint k=0; k<active.size(); ++k)
+		{
+			int i = active[k];
+
+			int cell = CellAt(m_vecSweepers.Position(i));
+
+			if (m_bBitboards) m_Visited.Set(cell);
+
+			//see if it's found a mine. Objects only ever go, so what was found is
+			//still what the serial order finds - unless a sweeper before this one
+			//took it, and then it is whatever is next on the cell
+			int GrabHit = m_vecStepHits[k];
+
+			if (GrabHit >= 0 && !m_vecObjects.Alive(GrabHit)) GrabHit = CheckForObject(cell);
 
 			if (GrabHit >= 0)
 			{
-				switch(m_vecObjects[GrabHit]->getType()){
+				switch(m_vecObjects[GrabHit].getType()){
 				case CDiscCollisionObject::Mine:
 					{
 					//we have discovered a mine so increase MinesGathered
-					(m_vecSweepers[i])->IncrementMinesGathered();
-					CDiscCollisionObject* oldObject = m_vecObjects[GrabHit];
-					oldObject->die();
+					m_vecSweepers.IncrementMinesGathered(i);
+					KillObject(GrabHit);
 					break;
 					}
 				case CDiscCollisionObject::Rock:
 					{
 					//destroy the sweeper until it reincarnates in the next round
-					//CDiscCollisionObject* oldObject = m_vecObjects[GrabHit];
-					//oldObject->die();
-					(m_vecSweepers[i])->die();
+					m_vecSweepers.Kill(i);
 					break;
 					}
 				case CDiscCollisionObject::SuperMine:
 					{
 					//destroy both the sweeper and the supermine until both reincarnate in the next round
-					CDiscCollisionObject* oldObject = m_vecObjects[GrabHit];
-					oldObject->die();
-					(m_vecSweepers[i])->die();
+					KillObject(GrabHit);
+					m_vecSweepers.Kill(i);
 					break;
 					}
 				}
 			}
 		}
+
+		//the ones that died stay where they are until the next round
+		m_vecSweepers.CompactActive();
 	}
 	//Time to update the sweepers for the next iteration
 	else
@@ -134,48 +507,57 @@ bool CDiscController::Update()
 		double sum = 0;
 		int maxMines = -1;
 		int deaths = 0;
-		for (auto i = m_vecSweepers.begin(); i != m_vecSweepers.end(); ++i){
-			sum += (*i)->MinesGathered();
-			if ((*i)->isDead())
+		for (int i = 0; i < (int)m_vecSweepers.size(); ++i){
+			sum += m_vecSweepers.MinesGathered(i);
+			if (!m_vecSweepers.Alive(i))
 				deaths++;
-			maxMines = max((*i)->MinesGathered(),maxMines);
+			if (m_vecSweepers.MinesGathered(i) > maxMines)
+				maxMines = (int)m_vecSweepers.MinesGathered(i);
 		}
 		
+		//the bitboard world can tell how much of it was covered at little cost
+		if (m_bBitboards)
+		{
+			int spanCells = (CParams::WorldWidth / CParams::iGridCellDim) * (CParams::WorldHeight / CParams::iGridCellDim);
+
+			std::cout << "World: " << m_Visited.Count() << "/" << spanCells << " cells visited, "
+					  << m_Live[CCollisionObject::Mine].Count() << "/" << m_Initial[CCollisionObject::Mine].Count()
+					  << " mine cells left" << std::endl;
+		}
+
 		m_vecAvMinesGathered.push_back(sum / float(m_vecSweepers.size()));
 		m_vecMostMinesGathered.push_back(maxMines);
 		m_vecDeaths.push_back(deaths);
 		m_vecMines.push_back(sum);
 
-		//WRITE DATA TO FILE//
-		if (m_iIterations == 0)
-		{
-			ofstream outputDeaths("deaths-enironment3.txt");
-			outputDeaths << deaths << "\n";
-			outputDeaths.close();
-
-			ofstream outputMines("AVGMinesPickup-enironment3.txt");
-			outputMines << (sum / float(m_vecSweepers.size())) << "\n";
-			outputMines.close();
+		EndTraceEpisode(deaths, sum);
 
-			ofstream outputMostMines("mostMineGathered-enironment3.txt");
-			outputMostMines << maxMines << "\n";
-			outputMostMines.close();
-		}
-		else
+		//WRITE DATA TO FILE// - a replay adds nothing to the stats of the recorded run
+		if (!m_pPlayer)
 		{
-			ofstream outputDeaths("deaths-enironment3.txt", std::ofstream::out | std::ofstream::app);
-			outputDeaths << deaths << "\n";
-			outputDeaths.close();
+			//a new file per run: <prefix>-<seed>.csv (or .bin), numbered -1, -2, ... after the
+			//first, so a reset or a rerun with the same seed keeps the earlier runs' stats
+			if (m_iIterations == 0)
+			{
+				string baseName = CParams::sStatsPrefix + "-" + itos(CParams::iRandomSeed);
+				string extension = CParams::iStatsFormat == BinaryStats ? ".bin" : ".csv";
 
-			ofstream outputMines("AVGMinesPickup-enironment3.txt", std::ofstream::out | std::ofstream::app);
-			outputMines << (sum / float(m_vecSweepers.size())) << "\n";
-			outputMines.close();
+				if (m_Stats.OpenNew(baseName, extension, CParams::iStatsFormat))
+					std::cout << "Stats go to " << m_Stats.FileName() << std::endl;
+				else
+					std::cout << "Could not create " << baseName << extension << ", no stats will be written" << std::endl;
+			}
+
+			SIterationStats stats;
+			stats.iteration = m_iIterations;
+			stats.numSweepers = (int32_t)m_vecSweepers.size();
+			stats.deaths = deaths;
+			stats.mostMines = maxMines;
+			stats.averageMines = sum / float(m_vecSweepers.size());
+			stats.minesGathered = sum;
 
-			ofstream outputMostMines("mostMineGathered-enironment3.txt", std::ofstream::out | std::ofstream::app);
-			outputMostMines << maxMines << "\n";
-			outputMostMines.close();
+			m_Stats.Push(stats);
 		}
-		
 
 		//increment the iteration counter
 		++m_iIterations;
@@ -183,20 +565,147 @@ bool CDiscController::Update()
 		//reset cycles
 		m_iTicks = 0;	
 		
-		//reset the sweepers positions etc
-		for (int i=0; i<m_NumSweepers; ++i)
+		//a replay goes back to the start of its episode, a scenario bank gives the
+		//next layout and anything else gets a new random start
+		if (!RewindReplay() && !NextScenario())
 		{
-			(m_vecSweepers[i])->Reset();
+			//reset the sweepers positions etc
+			m_vecSweepers.ResetAll();
+
+			//reset the objects:
+			ResetObjects();
 		}
 
-		//reset the objects:
-		for (auto i = m_vecObjects.begin(); i != m_vecObjects.end(); ++i)
-			(*i)->Reset();
+		BeginTraceEpisode();
 	}
 	return true;
 }
 
 
+//-------------------------------RecordLayout-------------------------------
+//
+//	objects and sweepers by cell, each as the zigzag varint difference from
+//	the one before (the object type and alive flag share a varint)
+//
+//-------------------------------------------------------------------------
+void CDiscController::RecordLayout(void)
+{
+	int prevX = 0, prevY = 0;
+
+	m_pRecorder->PutVarint(m_vecObjects.size());
+
+	for (int i = 0; i < (int)m_vecObjects.size(); ++i)
+	{
+		int x = m_vecObjects.X(i) / CParams::iGridCellDim;
+		int y = m_vecObjects.Y(i) / CParams::iGridCellDim;
+
+		m_pRecorder->PutVarint(m_vecObjects.Type(i) | (m_vecObjects.Alive(i) ? 4 : 0));
+		m_pRecorder->PutSigned(x - prevX);
+		m_pRecorder->PutSigned(y - prevY);
+
+		prevX = x;
+		prevY = y;
+	}
+
+	m_pRecorder->PutVarint(m_vecSweepers.size());
+
+	for (int i = 0; i < (int)m_vecSweepers.size(); ++i)
+	{
+		int x = m_vecSweepers.X(i) / CParams::iGridCellDim;
+		int y = m_vecSweepers.Y(i) / CParams::iGridCellDim;
+
+		m_pRecorder->PutSigned(x - prevX);
+		m_pRecorder->PutSigned(y - prevY);
+		m_pRecorder->PutVarint(m_vecSweepers.Rotation(i));
+
+		prevX = x;
+		prevY = y;
+	}
+}
+
+bool CDiscController::ReplayLayout(void)
+{
+	int x = 0, y = 0;
+
+	if (m_pPlayer->GetVarint() != m_vecObjects.size()) return false;
+
+	for (int i = 0; i < (int)m_vecObjects.size(); ++i)
+	{
+		uint code = (uint)m_pPlayer->GetVarint();
+
+		x += (int)m_pPlayer->GetSigned();
+		y += (int)m_pPlayer->GetSigned();
+
+		m_vecObjects.SetType(i, (CCollisionObject::ObjectType)(code & 3));
+		m_vecObjects.SetPosition(i, SVector2D<int>(x * CParams::iGridCellDim, y * CParams::iGridCellDim));
+
+		if (code & 4) m_vecObjects.Revive(i); else m_vecObjects.Kill(i);
+	}
+
+	if (m_pPlayer->GetVarint() != m_vecSweepers.size()) return false;
+
+	for (int i = 0; i < (int)m_vecSweepers.size(); ++i)
+	{
+		x += (int)m_pPlayer->GetSigned();
+		y += (int)m_pPlayer->GetSigned();
+
+		ROTATION_DIRECTION rotation = (ROTATION_DIRECTION)(m_pPlayer->GetVarint() & 3);
+
+		m_vecSweepers.Place(i, SVector2D<int>(x * CParams::iGridCellDim, y * CParams::iGridCellDim), rotation);
+	}
+
+	m_vecSweepers.RebuildActive();
+
+	//the objects may have moved, so index them again
+	BuildOccupancyIndex();
+
+	return !m_pPlayer->Failed();
+}
+
+void CDiscController::ApplyScenario(int layout)
+{
+	SScenarioLayout<int32_t> scenario = m_pScenarios->Layout<int32_t>(layout);
+
+	m_vecSweepers.PlaceAll(scenario.spawnX, scenario.spawnY, scenario.spawnRotation);
+
+	if (layout == m_iScenarioLayout)
+	{
+		ResetObjects();
+
+		return;
+	}
+
+	m_vecObjects.Assign(scenario.objectX, scenario.objectY, scenario.objectType);
+
+	//the objects have moved, so index them again
+	BuildOccupancyIndex();
+}
+
+//-------------------------------RecordTick---------------------------------
+//
+//	the heading (which is the action index) of every sweeper, straight from
+//	the pool. Skipping the dead ones would save a few bits at the cost of a
+//	pass over the active list, and recording has to keep up with a frozen
+//	policy that barely costs more than the move itself
+//
+//-------------------------------------------------------------------------
+void CDiscController::RecordTick(void)
+{
+	m_pRecorder->BeginTick();
+	m_pRecorder->PutSymbols(m_vecSweepers.Rotations(), m_vecSweepers.size());
+	m_pRecorder->EndTick();
+}
+
+void CDiscController::ReplayTick(void)
+{
+	for (int i = 0; i < (int)m_vecSweepers.size(); ++i)
+	{
+		m_vecSweepers.SetRotation(i, (ROTATION_DIRECTION)m_pPlayer->GetSymbol());
+	}
+}
+
+#ifdef _WIN32
+
 //------------------------------------Render()--------------------------------------
 //
 //----------------------------------------------------------------------------------
@@ -208,40 +717,59 @@ void CDiscController::Render(HDC surface)
 	//do not render if running at accelerated speed
 	if (!m_bFastRender)
 	{
+		//where the window is, when the world does not fit in it
+		if (CParams::WorldWidth > CParams::WindowWidth || CParams::WorldHeight > CParams::WindowHeight)
+		{
+			s = "View: " + itos(m_iViewX / CParams::iGridCellDim) + ", " + itos(m_iViewY / CParams::iGridCellDim) +
+				" of " + itos(m_iGridX) + " x " + itos(m_iGridY) + " cells";
+			TextOut(surface, 5, 20, s.c_str(), s.size());
+		}
+
 		//keep a record of the old pen
 		m_OldPen = (HPEN)SelectObject(surface, m_GreenPen);
 		
-		//render the mines
-		for (int i=0; i<m_NumMines+m_NumSuperMines+m_NumRocks; ++i)
+		//render the mines - only the cells in view are looked at, however big
+		//the world is, and a cell's objects of one type all look the same
+		int lastX = std::min(m_iGridX - 1, (m_iViewX + CParams::WindowWidth) / CParams::iGridCellDim);
+		int lastY = std::min(m_iGridY - 1, (m_iViewY + CParams::WindowHeight) / CParams::iGridCellDim);
+
+		for (int x = m_iViewX / CParams::iGridCellDim; x <= lastX; ++x)
 		{
-			if ((m_vecObjects[i])->isDead()) continue; //skip if dead
-			if ( m_vecObjects[i]->getType() == CCollisionObject::Mine)
-			{
-				SelectObject(surface, m_GreenPen);
-			}
-			else if ( m_vecObjects[i]->getType() == CCollisionObject::Rock)
-			{
-				SelectObject(surface, m_BluePen );
-			}
-			else if ( m_vecObjects[i]->getType() == CCollisionObject::SuperMine)
+			for (int y = m_iViewY / CParams::iGridCellDim; y <= lastY; ++y)
 			{
-				SelectObject(surface, m_RedPen);
-			}
-			//grab the vertices for the mine shape
-			vector<SPoint> mineVB = m_MineVB;
+				for (int type = 0; type < CCollisionObject::NUM_OBJECT_TYPES; ++type)
+				{
+					if (!HasLiveObject(type, CellIndex(x, y))) continue;
 
-			WorldTransform<int>(mineVB, m_vecObjects[i]->getPosition());
+					if (type == CCollisionObject::Mine)
+					{
+						SelectObject(surface, m_GreenPen);
+					}
+					else if (type == CCollisionObject::Rock)
+					{
+						SelectObject(surface, m_BluePen );
+					}
+					else if (type == CCollisionObject::SuperMine)
+					{
+						SelectObject(surface, m_RedPen);
+					}
+					//grab the vertices for the mine shape
+					vector<SPoint> mineVB = m_MineVB;
 
-			//draw the mines
-			MoveToEx(surface, (int)mineVB[0].x, (int)mineVB[0].y, NULL);
+					WorldTransform<int>(mineVB, SVector2D<int>(x * CParams::iGridCellDim - m_iViewX,
+															   y * CParams::iGridCellDim - m_iViewY));
 
-			for (int vert=1; vert<mineVB.size(); ++vert)
-			{
-				LineTo(surface, (int)mineVB[vert].x, (int)mineVB[vert].y);
-			}
+					//draw the mines
+					MoveToEx(surface, (int)mineVB[0].x, (int)mineVB[0].y, NULL);
 
-			LineTo(surface, (int)mineVB[0].x, (int)mineVB[0].y);
-			
+					for (int vert=1; vert<mineVB.size(); ++vert)
+					{
+						LineTo(surface, (int)mineVB[vert].x, (int)mineVB[vert].y);
+					}
+
+					LineTo(surface, (int)mineVB[0].x, (int)mineVB[0].y);
+				}
+			}
 		}
        		
 		//we want some sweepers displayed in red
@@ -254,13 +782,26 @@ void CDiscController::Render(HDC surface)
 			{
 				SelectObject(surface, m_OldPen);
 			}
-			if (m_vecSweepers[i]->isDead()) continue; //skip if dead
+			if (!m_vecSweepers.Alive(i)) continue; //skip if dead
+
+			//skip if out of view
+			int viewX = m_vecSweepers.X(i) - m_iViewX;
+			int viewY = m_vecSweepers.Y(i) - m_iViewY;
+
+			if (viewX < -CParams::iGridCellDim || viewX > CParams::WindowWidth + CParams::iGridCellDim ||
+				viewY < -CParams::iGridCellDim || viewY > CParams::WindowHeight + CParams::iGridCellDim) continue;
 
 			//grab the sweeper vertices
 			vector<SPoint> sweeperVB = m_SweeperVB;
 
-			//transform the vertex buffer
-			(m_vecSweepers[i])->WorldTransform(sweeperVB);
+			//transform the vertex buffer, then into the view
+			m_vecSweepers[i].WorldTransform(sweeperVB);
+
+			for (int vert=0; vert<sweeperVB.size(); ++vert)
+			{
+				sweeperVB[vert].x -= m_iViewX;
+				sweeperVB[vert].y -= m_iViewY;
+			}
 
 			//draw the sweeper left track
 			MoveToEx(surface, (int)sweeperVB[0].x, (int)sweeperVB[0].y, NULL);
@@ -304,4 +845,85 @@ void CDiscController::Render(HDC surface)
     PlotStats(surface);
   }
 
+}
+
+#endif
+
+//-------------------------BenchmarkOccupancyIndex--------------------------
+//
+//	half the objects are killed first, so the collision test has dead
+//	objects to skip. The scans work the cell out from the position with
+//	two divisions per object, as R() used to
+//
+//-------------------------------------------------------------------------
+void CDiscController::BenchmarkOccupancyIndex(uint queries)
+{
+	CRandomStream rng(12345);
+
+	for (int i = 0; i < (int)m_vecObjects.size(); ++i)
+	{
+		if (rng.RandInt(0, 1) && m_vecObjects.Alive(i)) KillObject(i);
+	}
+
+	std::vector<int> queryCells(queries);
+	for (uint q = 0; q < queries; ++q)
+	{
+		queryCells[q] = rng.RandInt(0, m_iGridX * m_iGridY - 1);
+	}
+
+	int numObjects = (int)m_vecObjects.size();
+
+	//the scans are linear in the objects, so they get fewer queries
+	uint scanQueries = queries / (1 + numObjects / 1000);
+	if (scanQueries == 0) scanQueries = 1;
+
+	std::vector<int> scanFirst(scanQueries), scanHit(scanQueries);
+
+	double start = HighResTime();
+	for (uint q = 0; q < scanQueries; ++q)
+	{
+		int x = queryCells[q] / m_iGridY;
+		int y = queryCells[q] % m_iGridY;
+
+		int first = -1;
+		int hit[CCollisionObject::NUM_OBJECT_TYPES] = {-1, -1, -1};
+
+		for (int i = 0; i < numObjects; ++i)
+		{
+			SVector2D<int> position = m_vecObjects.Position(i);
+
+			if (position.x / CParams::iGridCellDim != x || position.y / CParams::iGridCellDim != y) continue;
+
+			if (first == -1) first = i;
+			if (hit[m_vecObjects.Type(i)] == -1 && m_vecObjects.Alive(i)) hit[m_vecObjects.Type(i)] = i;
+		}
+
+		scanFirst[q] = first;
+		scanHit[q] = hit[CCollisionObject::Mine] != -1 ? hit[CCollisionObject::Mine] :
+					 hit[CCollisionObject::Rock] != -1 ? hit[CCollisionObject::Rock] : hit[CCollisionObject::SuperMine];
+	}
+	double scanTime = HighResTime() - start;
+
+	long checksum = 0;
+	bool match = true;
+
+	start = HighResTime();
+	for (uint q = 0; q < queries; ++q)
+	{
+		int first = FirstObjectInCell(queryCells[q]);
+		int hit = CheckForObject(queryCells[q]);
+
+		checksum += first + hit;
+		if (q < scanQueries && (first != scanFirst[q] || hit != scanHit[q])) match = false;
+	}
+	double indexTime = HighResTime() - start;
+
+	std::cout << "Occupancy index, " << m_iGridX << "x" << m_iGridY << " cells, " << numObjects << " objects ("
+			  << (m_bBitboards ? "bitboards" : "chains") << "):" << std::endl;
+	std::cout << "  scan query:     " << scanTime / scanQueries * 1e9 << " ns" << std::endl;
+	std::cout << "  index query:    " << indexTime / queries * 1e9 << " ns" << std::endl;
+	std::cout << "  index " << (match ? "matches" : "DOES NOT MATCH") << " the scans"
+			  << " (checksum " << checksum << ")" << std::endl;
+
+	ResetObjects();
 }
\ No newline at end of file
@@ -1,27 +1,169 @@
 #pragma once
-#include "ccontroller.h"
+#include "CController.h"
 #include "CDiscCollisionObject.h"
-#include "CDiscMinesweeper.h"
+#include "CSweeperPool.h"
+#include "CPolicyMap.h"
+#include "CDistanceField.h"
+#include "CBitboard.h"
+#include "CStatsWriter.h"
 #include <assert.h>
+
+//the per cell object chains cost 28 bytes a cell, so a world of more cells
+//than this is always kept as bitboards (which give the same results)
+const int MAX_CHAIN_INDEX_CELLS = 1 << 20;
+
 class CDiscController :
 	public CController
 {
 protected:
 	//and the minesweepers
-    vector<CDiscMinesweeper*> m_vecSweepers;
+	CSweeperPool m_vecSweepers;
 
 	//and the mines
-	vector<CDiscCollisionObject*> m_vecObjects;
+	CDiscObjectPool m_vecObjects;
+
+	//grid dimensions in cells (objects and sweepers can sit on the far edge, hence the +1)
+	int m_iGridX;
+	int m_iGridY;
+
+	//per-cell occupancy index. Objects never move in the discrete world, so each
+	//cell keeps, for every object type, a chain of the objects of that type placed
+	//on it in ascending index order (m_vecTypeFirst -> m_vecObjectNext -> ... -> -1).
+	//m_vecTypeHead holds the first object of each chain that is still alive and is
+	//advanced as objects die, so a collision test never walks a chain.
+	//All per-type vectors are indexed [type * cells + cell].
+	vector<int> m_vecCellFirst;
+	vector<int> m_vecTypeFirst;
+	vector<int> m_vecTypeHead;
+	vector<int> m_vecObjectNext;
+
+	//bitboard world (bBitboardWorld): the chains above are replaced by a bit per cell
+	//for every object type, set while the cell holds a live object of that type, the
+	//same boards as they were when the objects were placed (a reset copies them back)
+	//and a board of the cells the sweepers have stepped on this iteration. Only the
+	//cells with a bit set are looked up in m_vecCellObjects - every object as
+	//cell << 32 | index, sorted - so the world costs a few bits per cell.
+	//m_vecWordStart[w] is where the entries of the 64 cells of board word w
+	//start, so a lookup only searches its own word's few entries
+	bool m_bBitboards;
+	CBitboard m_Live[CCollisionObject::NUM_OBJECT_TYPES];
+	CBitboard m_Initial[CCollisionObject::NUM_OBJECT_TYPES];
+	CBitboard m_Visited;
+	vector<uint64_t> m_vecCellObjects;
+	vector<uint32_t> m_vecWordStart;
+
+	//lowest numbered live object of a type on a cell of the bitboard world, -1 if none
+	int FirstLiveObject(int type, int cell) const;
+
+	//whether a cell holds a live object of a type, in either storage
+	bool HasLiveObject(int type, int cell) const
+	{
+		if (m_bBitboards) return m_Live[type].Test(cell);
+		return m_vecTypeHead[type * m_iGridX * m_iGridY + cell] != -1;
+	}
+
+	//distance to the nearest live object of each type, over the cells the sweepers can
+	//stand on. A reset only marks the fields stale; they are rebuilt by the first query
+	//after it and then updated incrementally as objects die, so a controller that never
+	//asks pays nothing for them
+	CDistanceField m_Fields[CCollisionObject::NUM_OBJECT_TYPES];
+	vector<int> m_vecFieldSources;
+	bool m_bFieldsStale;
+
+	//builds the occupancy index from m_vecObjects
+	void BuildOccupancyIndex(void);
+
+	//rebuilds every distance field from the heads of the occupancy index
+	void BuildDistanceFields(void);
+
+	//kills an object and keeps the occupancy index up to date
+	void KillObject(int index);
+
+	//revives every object for the next iteration
+	void ResetObjects(void);
+
+	//cell index of a grid coordinate / of a position in pixels
+	int CellIndex(int x, int y) const {return x * m_iGridY + y;}
+	int CellAt(SVector2D<int> position) const {return CellIndex(position.x / CParams::iGridCellDim, position.y / CParams::iGridCellDim);}
+
+	//first object placed on a cell (alive or not), -1 if there is none
+	int FirstObjectInCell(int cell) const;
+
+	//returns the live object a sweeper standing on the cell collides with, -1 if none.
+	//Mines take priority over rocks and rocks over supermines, lowest index first
+	int CheckForObject(int cell) const;
+
+	//live object types around a grid coordinate: 2 bits (0 = none, 1 + ObjectType)
+	//for each cell of the 3x3 block centred on it, row by row
+	uint32_t LocalView(int x, int y) const;
+
+	//frozen greedy policy the sweepers follow in evaluation mode, NULL while learning
+	const CPolicyMap* m_pPolicy;
+
+	//episode traces: the cells of the objects and sweepers, then the heading
+	//of every sweeper per tick (the dead ones keep theirs)
+	virtual int TraceWorldType(void)const{return DiscreteTrace;}
+	virtual void RecordLayout(void);
+	virtual bool ReplayLayout(void);
+	void RecordTick(void);
+	void ReplayTick(void);
+
+	//scenario layouts: the spawns are copied in every episode, the objects
+	//only when the layout changes (they never move in the discrete world)
+	virtual void ApplyScenario(int layout);
+
+	//per iteration stats file, written on a background thread
+	CStatsWriter m_Stats;
+
+	//the object each live sweeper hit this tick (-1 for none), in active order
+	vector<int> m_vecStepHits;
+
+	//top left corner of the part of the world the window shows, in pixels
+	int m_iViewX;
+	int m_iViewY;
 
 public:
 	CDiscController(HWND hwndMain);
 	virtual ~CDiscController(void);
+#ifdef _WIN32
 	virtual void Render(HDC surface);
+#endif
 	virtual bool Update(void);
 	virtual void InitializeLearningAlgorithm(void);
 	virtual void InitializeSweepers(void);
 	virtual void InitializeMines(void);
 	virtual void InitializeSuperMines(void);
 	virtual void InitializeRocks(void);
+
+	//steps from a grid coordinate to the nearest live object of a type (wrapping around the
+	//edges like the sweepers) and that object's index, -1 if there is none. Both O(1), apart
+	//from the first query of an iteration, which rebuilds the fields
+	int DistanceToObject(CCollisionObject::ObjectType type, int x, int y)
+	{
+		if (m_bFieldsStale) BuildDistanceFields();
+		return m_Fields[type].Distance(x, y);
+	}
+	int ClosestObject(CCollisionObject::ObjectType type, int x, int y)
+	{
+		if (m_bFieldsStale) BuildDistanceFields();
+		return m_Fields[type].Nearest(x, y);
+	}
+
+	//steps the sweepers from a compiled policy map instead of their own rotation
+	//(NULL goes back to letting the learning algorithm steer)
+	void SetPolicy(const CPolicyMap* policy){m_pPolicy = policy;}
+
+	//bytes held by the world: the objects, their index (chains or bitboards)
+	//and the distance fields, if they have been built
+	size_t WorldBytes(void) const;
+	bool BitboardWorld(void) const {return m_bBitboards;}
+
+	//moves the window over a world bigger than it, by a number of cells
+	virtual void ScrollView(int dx, int dy);
+
+	//times FirstObjectInCell and CheckForObject on random cells of the current world
+	//against scans of every object (what R() and the collision test used to do), and
+	//checks the index finds what the scans do. Every object is alive again afterwards
+	void BenchmarkOccupancyIndex(uint queries);
 };
 
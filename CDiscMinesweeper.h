@@ -7,62 +7,55 @@
 //
 //  Author: Mat Buckland 2002
 //
-//  Desc: Class to create a minesweeper object 
+//  Desc: Class to create a minesweeper object. The discrete sweepers
+//        themselves live in a CSweeperPool; this is a reference to one of
+//        them with the per sweeper accessors
 //
 //------------------------------------------------------------------------
 #include <vector>
-#include <math.h>
 #include "utils.h"
 #include "C2DMatrix.h"
 #include "SVector2D.h"
 #include "CParams.h"
-#include "CDiscCollisionObject.h"
-#include "CMinesweeper.h"
 using namespace std;
 
 enum ROTATION_DIRECTION {NORTH=1, SOUTH=3, EAST=0, WEST=2};
-class CDiscMinesweeper:public CMinesweeper
+
+class CSweeperPool;
+
+class CDiscMinesweeper
 {
 
 private:
-	//its position in the world
-	SVector2D<int>		m_vPosition;
-	SVector2D<int>		m_vPrevPosition;
-	//direction sweeper is facing
-	SVector2D<int>		m_vLookAt;
-
-	//its rotation (surprise surprise)
-	ROTATION_DIRECTION	m_dRotation;
-	
-	//sets the internal closest object variables for the 3 types of objects
-	void GetClosestObjects(vector<CDiscCollisionObject*> &objects);
+	CSweeperPool*		m_pPool;
+	int					m_iIndex;
+
 public:
 
+	CDiscMinesweeper(CSweeperPool* pool, int index):m_pPool(pool), m_iIndex(index){}
+
 	void setRotation(ROTATION_DIRECTION rotForce);
-	ROTATION_DIRECTION getRotation();
+	ROTATION_DIRECTION getRotation()const;
 
-	CDiscMinesweeper();
-	
-	//updates the information from the sweepers enviroment
-	bool			Update(vector<CDiscCollisionObject*> &objects);
+	//moves the sweeper one cell in the direction it is facing
+	//(the controller moves them all at once with CSweeperPool::Move)
+	bool			Update();
 
 	//used to transform the sweepers vertices prior to rendering
-	void			WorldTransform(vector<SPoint> &sweeper);
-
-	//checks to see if the minesweeper has 'collected' a mine
-	int       CheckForObject(vector<CDiscCollisionObject*> &objects, int size);
+	void			WorldTransform(vector<SPoint> &sweeper)const;
 
 	void			Reset();
-  
+
+	void			IncrementMinesGathered();
+	double			MinesGathered()const;
+	void			die();
+	bool			isDead()const;
 
 	//-------------------accessor functions
-	SVector2D<int>	Position()const{return SVector2D<int>(m_vPosition.x,m_vPosition.y);}
-	SVector2D<int>	PrevPosition()const{return SVector2D<int>(m_vPrevPosition.x,m_vPrevPosition.y);}
-  
+	SVector2D<int>	Position()const;
 };
 
 
 #endif
 
-	
-	
\ No newline at end of file
+
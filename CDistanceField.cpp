@@ -0,0 +1,316 @@
+#include "CDistanceField.h"
+#include "CRandom.h"
+#include "utils.h"
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+
+const int CDistanceField::UNREACHED;
+
+CDistanceField::CDistanceField(): m_iSpanX(0),
+								  m_iSpanY(0)
+{
+}
+
+//-------------------------------Allocate()--------------------------------
+//
+//	the search buffers are sized for the worst case here: every cell is
+//	queued at most once per update and has at most four border neighbours
+//
+//-------------------------------------------------------------------------
+void CDistanceField::Allocate(int spanX, int spanY)
+{
+	m_iSpanX = spanX;
+	m_iSpanY = spanY;
+
+	int cells = spanX * spanY;
+
+	m_vecDistance.assign(cells, UNREACHED);
+	m_vecNearest.assign(cells, -1);
+
+	m_vecQueue.clear();
+	m_vecQueue.reserve(cells);
+	m_vecRegion.clear();
+	m_vecRegion.reserve(cells);
+	m_vecSeeds.clear();
+	m_vecSeeds.reserve(4 * cells);
+}
+
+void CDistanceField::Neighbours(int cell, int * neighbours) const
+{
+	int x = cell / m_iSpanY;
+	int y = cell % m_iSpanY;
+
+	neighbours[0] = Index(x + 1 == m_iSpanX ? 0 : x + 1, y);
+	neighbours[1] = Index(x == 0 ? m_iSpanX - 1 : x - 1, y);
+	neighbours[2] = Index(x, y + 1 == m_iSpanY ? 0 : y + 1);
+	neighbours[3] = Index(x, y == 0 ? m_iSpanY - 1 : y - 1);
+}
+
+//-------------------------------Propagate()-------------------------------
+//
+//	every step costs one, so taking cells in distance order - the queue
+//	only ever grows in distance, so merging it with the sorted seeds is
+//	enough - settles each cell the first time it is improved
+//
+//-------------------------------------------------------------------------
+void CDistanceField::Propagate(void)
+{
+	std::sort(m_vecSeeds.begin(), m_vecSeeds.end());
+
+	size_t seed = 0;
+	size_t head = 0;
+
+	while (seed < m_vecSeeds.size() || head < m_vecQueue.size())
+	{
+		int cell;
+
+		if (head < m_vecQueue.size() &&
+			(seed == m_vecSeeds.size() || m_vecDistance[m_vecQueue[head]] <= m_vecSeeds[seed].first))
+		{
+			cell = m_vecQueue[head++];
+		}
+		else
+		{
+			cell = m_vecSeeds[seed++].second;
+		}
+
+		int distance = m_vecDistance[cell] + 1;
+		int neighbours[4];
+		Neighbours(cell, neighbours);
+
+		for (int n = 0; n < 4; ++n)
+		{
+			if (m_vecDistance[neighbours[n]] > distance)
+			{
+				m_vecDistance[neighbours[n]] = distance;
+				m_vecNearest[neighbours[n]] = m_vecNearest[cell];
+				m_vecQueue.push_back(neighbours[n]);
+			}
+		}
+	}
+
+	m_vecQueue.clear();
+	m_vecSeeds.clear();
+}
+
+void CDistanceField::Rebuild(const std::vector<int> &sources)
+{
+	std::fill(m_vecDistance.begin(), m_vecDistance.end(), UNREACHED);
+	std::fill(m_vecNearest.begin(), m_vecNearest.end(), -1);
+
+	for (int cell = 0; cell < (int)sources.size(); ++cell)
+	{
+		if (sources[cell] == -1) continue;
+
+		m_vecDistance[cell] = 0;
+		m_vecNearest[cell] = sources[cell];
+		m_vecQueue.push_back(cell);
+	}
+
+	Propagate();
+}
+
+//-------------------------------AddSource()-------------------------------
+//
+//	only the cells the new source is strictly closer to change
+//
+//-------------------------------------------------------------------------
+void CDistanceField::AddSource(int x, int y, int object)
+{
+	int cell = Index(x, y);
+
+	//already a source - the object there stays the nearest
+	if (m_vecDistance[cell] == 0) return;
+
+	m_vecDistance[cell] = 0;
+	m_vecNearest[cell] = object;
+	m_vecQueue.push_back(cell);
+
+	Propagate();
+}
+
+//------------------------------RemoveSource()-----------------------------
+//
+//	every cell takes its nearest object from a neighbour one step closer,
+//	so the cells that were nearest to the removed object form a connected
+//	region around it. That region is cleared and refilled from the cells
+//	on its border, which still hold correct distances.
+//
+//-------------------------------------------------------------------------
+void CDistanceField::RemoveSource(int x, int y, int replacement)
+{
+	int source = Index(x, y);
+
+	if (m_vecDistance[source] != 0) return;
+
+	int object = m_vecNearest[source];
+
+	//another object on the same cell takes over the whole region unchanged
+	int label = replacement;
+
+	m_vecRegion.push_back(source);
+	m_vecNearest[source] = label;
+	if (label == -1) m_vecDistance[source] = UNREACHED;
+
+	for (size_t r = 0; r < m_vecRegion.size(); ++r)
+	{
+		int neighbours[4];
+		Neighbours(m_vecRegion[r], neighbours);
+
+		for (int n = 0; n < 4; ++n)
+		{
+			if (m_vecNearest[neighbours[n]] != object) continue;
+
+			m_vecNearest[neighbours[n]] = label;
+			if (label == -1) m_vecDistance[neighbours[n]] = UNREACHED;
+			m_vecRegion.push_back(neighbours[n]);
+		}
+	}
+
+	if (label == -1)
+	{
+		for (size_t r = 0; r < m_vecRegion.size(); ++r)
+		{
+			int neighbours[4];
+			Neighbours(m_vecRegion[r], neighbours);
+
+			for (int n = 0; n < 4; ++n)
+			{
+				if (m_vecNearest[neighbours[n]] == -1) continue;
+
+				m_vecSeeds.push_back(std::make_pair(m_vecDistance[neighbours[n]], neighbours[n]));
+			}
+		}
+
+		Propagate();
+	}
+
+	m_vecRegion.clear();
+}
+
+//-----------------------BenchmarkDistanceField----------------------------
+//
+//	objects are dropped on random cells, several to a cell once there are
+//	more objects than cells. Removals take random live objects. Also checks
+//	that the incrementally updated field matches a fresh rebuild.
+//
+//-------------------------------------------------------------------------
+void BenchmarkDistanceField(int spanX, int spanY, int numObjects, uint queries)
+{
+	CRandomStream rng(12345);
+
+	int cells = spanX * spanY;
+
+	std::vector<int> objectCell(numObjects);
+	std::vector<std::vector<int> > cellObjects(cells);
+
+	for (int i = 0; i < numObjects; ++i)
+	{
+		objectCell[i] = rng.RandInt(0, cells - 1);
+		cellObjects[objectCell[i]].push_back(i);
+	}
+
+	std::vector<int> sources(cells, -1);
+	for (int cell = 0; cell < cells; ++cell)
+	{
+		if (!cellObjects[cell].empty()) sources[cell] = cellObjects[cell][0];
+	}
+
+	CDistanceField field;
+	field.Allocate(spanX, spanY);
+
+	double start = HighResTime();
+	field.Rebuild(sources);
+	double rebuildTime = HighResTime() - start;
+
+	std::vector<int> queryX(queries), queryY(queries);
+	for (uint q = 0; q < queries; ++q)
+	{
+		queryX[q] = rng.RandInt(0, spanX - 1);
+		queryY[q] = rng.RandInt(0, spanY - 1);
+	}
+
+	//the scan is linear in the objects, so it gets fewer queries
+	uint scanQueries = queries / (1 + numObjects / 1000);
+	if (scanQueries == 0) scanQueries = 1;
+
+	long checksum = 0;
+
+	start = HighResTime();
+	for (uint q = 0; q < scanQueries; ++q)
+	{
+		double closest = 99999;
+		int nearest = -1;
+
+		for (int i = 0; i < numObjects; ++i)
+		{
+			double dx = objectCell[i] / spanY - queryX[q];
+			double dy = objectCell[i] % spanY - queryY[q];
+			double length = sqrt(dx * dx + dy * dy);
+
+			if (length < closest)
+			{
+				closest = length;
+				nearest = i;
+			}
+		}
+
+		checksum += nearest;
+	}
+	double scanTime = HighResTime() - start;
+
+	start = HighResTime();
+	for (uint q = 0; q < queries; ++q)
+	{
+		checksum += field.Nearest(queryX[q], queryY[q]);
+	}
+	double fieldTime = HighResTime() - start;
+
+	//remove up to half the objects, one at a time
+	int removals = numObjects / 2 < 1000 ? numObjects / 2 : 1000;
+	std::vector<int> order(numObjects);
+	for (int i = 0; i < numObjects; ++i) order[i] = i;
+
+	start = HighResTime();
+	for (int k = 0; k < removals; ++k)
+	{
+		std::swap(order[k], order[rng.RandInt(k, numObjects - 1)]);
+
+		int cell = objectCell[order[k]];
+		std::vector<int> &onCell = cellObjects[cell];
+
+		onCell.erase(std::find(onCell.begin(), onCell.end(), order[k]));
+
+		if (sources[cell] == order[k])
+		{
+			sources[cell] = onCell.empty() ? -1 : onCell[0];
+			field.RemoveSource(cell / spanY, cell % spanY, sources[cell]);
+		}
+	}
+	double removeTime = HighResTime() - start;
+
+	CDistanceField rebuilt;
+	rebuilt.Allocate(spanX, spanY);
+	rebuilt.Rebuild(sources);
+
+	bool match = true;
+	for (int x = 0; x < spanX; ++x)
+	{
+		for (int y = 0; y < spanY; ++y)
+		{
+			if (field.Distance(x, y) != rebuilt.Distance(x, y)) match = false;
+		}
+	}
+
+	std::cout << "Distance field, " << spanX << "x" << spanY << " world, " << numObjects << " objects:" << std::endl;
+	std::cout << "  rebuild:        " << rebuildTime * 1e6 << " us" << std::endl;
+	std::cout << "  scan query:     " << scanTime / scanQueries * 1e9 << " ns" << std::endl;
+	std::cout << "  field query:    " << fieldTime / queries * 1e9 << " ns" << std::endl;
+	if (removals > 0)
+	{
+		std::cout << "  remove object:  " << removeTime / removals * 1e6 << " us" << std::endl;
+	}
+	std::cout << "  incremental field " << (match ? "matches" : "DOES NOT MATCH") << " a rebuild"
+			  << " (checksum " << checksum << ")" << std::endl;
+}
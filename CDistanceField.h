@@ -0,0 +1,95 @@
+#ifndef CDISTANCEFIELD_H
+#define CDISTANCEFIELD_H
+//------------------------------------------------------------------------
+//
+//	Name: CDistanceField.h
+//
+//  Desc: Distance field over the discrete world: for every cell, the
+//        number of sweeper steps to the nearest source (a live object of
+//        one type) and which object that is. Distances wrap around the
+//        edges exactly like the sweepers do, so they are true step counts
+//        on the torus, not straight line lengths.
+//
+//        The field is built by a multi-source breadth first search and
+//        then kept up to date incrementally: a new source only relaxes the
+//        cells it gets closer to, and a removed source only repairs the
+//        region that was nearest to it, seeded from that region's border.
+//        A query is a single array read.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+class CDistanceField
+{
+private:
+	//distance of a cell no source can reach
+	static const int UNREACHED = 0x7FFFFFFF;
+
+	int					m_iSpanX;
+	int					m_iSpanY;
+
+	std::vector<int>	m_vecDistance;
+	std::vector<int>	m_vecNearest;
+
+	//search buffers, sized in Allocate so an update never allocates
+	std::vector<int>	m_vecQueue;
+	std::vector<int>	m_vecRegion;
+	std::vector<std::pair<int, int> >	m_vecSeeds;
+
+	int		Index(int x, int y)const{return x * m_iSpanY + y;}
+
+	//the four cells a sweeper can step to from a cell
+	void	Neighbours(int cell, int * neighbours) const;
+
+	//breadth first search outwards from the cells in m_vecQueue, merged in
+	//distance order with the (sorted) border cells in m_vecSeeds
+	void	Propagate(void);
+
+public:
+	CDistanceField();
+
+	//sizes the field for a spanX by spanY torus with no sources
+	void	Allocate(int spanX, int spanY);
+
+	//rebuilds the whole field. sources[Index(x, y)] is the object sitting
+	//on (x, y) or -1
+	void	Rebuild(const std::vector<int> &sources);
+
+	//an object has appeared on (x, y)
+	void	AddSource(int x, int y, int object);
+
+	//the object on (x, y) is gone. replacement is another object of the
+	//same type still on that cell, or -1 if the cell is now empty
+	void	RemoveSource(int x, int y, int replacement);
+
+	//steps from (x, y) to the nearest source, -1 if there is none
+	int		Distance(int x, int y)const
+	{
+		int distance = m_vecDistance[Index(x, y)];
+
+		return distance == UNREACHED ? -1 : distance;
+	}
+
+	//that source's object, -1 if there is none
+	int		Nearest(int x, int y)const{return m_vecNearest[Index(x, y)];}
+
+	int		SpanX()const{return m_iSpanX;}
+	int		SpanY()const{return m_iSpanY;}
+
+	//bytes held by the field and its search buffers (0 until it is allocated)
+	size_t	Bytes()const
+	{
+		return (m_vecDistance.size() + m_vecNearest.size() + m_vecQueue.size() + m_vecRegion.size()) * sizeof(int) +
+			   m_vecSeeds.size() * sizeof(std::pair<int, int>);
+	}
+};
+
+//times nearest object queries against the field and against a scan of
+//every object (the old per-sweeper search), plus the field's updates, on
+//a spanX by spanY world with the given number of objects
+void BenchmarkDistanceField(int spanX, int spanY, int numObjects, uint queries);
+
+#endif
@@ -0,0 +1,125 @@
+#include "CMappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+
+CMappedFile::CMappedFile(): m_pData(NULL),
+							m_iSize(0),
+							m_hFile(INVALID_HANDLE_VALUE),
+							m_hMapping(NULL)
+{
+}
+
+bool CMappedFile::Open(const char* szFileName)
+{
+	Close();
+
+	m_hFile = CreateFileA(szFileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+						  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (m_hFile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(m_hFile, &size) || size.QuadPart == 0)
+	{
+		Close();
+
+		return false;
+	}
+
+	m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (m_hMapping)
+	{
+		m_pData = (const char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	}
+
+	if (!m_pData)
+	{
+		Close();
+
+		return false;
+	}
+
+	m_iSize = (size_t)size.QuadPart;
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+
+	m_pData = NULL;
+	m_iSize = 0;
+	m_hMapping = NULL;
+	m_hFile = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+CMappedFile::CMappedFile(): m_pData(NULL),
+							m_iSize(0),
+							m_iFile(-1)
+{
+}
+
+bool CMappedFile::Open(const char* szFileName)
+{
+	Close();
+
+	m_iFile = open(szFileName, O_RDONLY);
+
+	if (m_iFile < 0) return false;
+
+	struct stat info;
+
+	if (fstat(m_iFile, &info) != 0 || info.st_size == 0)
+	{
+		Close();
+
+		return false;
+	}
+
+	void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_iFile, 0);
+
+	if (data == MAP_FAILED)
+	{
+		Close();
+
+		return false;
+	}
+
+	m_pData = (const char*)data;
+	m_iSize = (size_t)info.st_size;
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (m_pData) munmap((void*)m_pData, m_iSize);
+	if (m_iFile >= 0) close(m_iFile);
+
+	m_pData = NULL;
+	m_iSize = 0;
+	m_iFile = -1;
+}
+
+#endif
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
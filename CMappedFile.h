@@ -0,0 +1,43 @@
+#ifndef CMAPPEDFILE_H
+#define CMAPPEDFILE_H
+//------------------------------------------------------------------------
+//
+//	Name: CMappedFile.h
+//
+//  Desc: Read only memory mapping of a whole file. Used to load binary
+//        checkpoints without reading them through a stream - the pages
+//        come straight from the file cache.
+//
+//------------------------------------------------------------------------
+#include <stddef.h>
+
+class CMappedFile
+{
+private:
+	const char*	m_pData;
+	size_t		m_iSize;
+
+#ifdef _WIN32
+	void*		m_hFile;
+	void*		m_hMapping;
+#else
+	int			m_iFile;
+#endif
+
+	//a mapping cannot be shared
+	CMappedFile(const CMappedFile&);
+	CMappedFile& operator=(const CMappedFile&);
+
+public:
+	CMappedFile();
+	~CMappedFile();
+
+	//maps the file, returns false if it cannot be opened or is empty
+	bool		Open(const char* szFileName);
+	void		Close();
+
+	const char*	Data()const{return m_pData;}
+	size_t		Size()const{return m_iSize;}
+};
+
+#endif
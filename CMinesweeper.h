@@ -3,6 +3,7 @@
 #include "utils.h"
 #include "SVector2D.h"
 #include "CParams.h"
+#include "CRandom.h"
 
 class CMinesweeper
 {
@@ -18,11 +19,15 @@ protected:
 	int				m_iClosestSupermine;
 	
 	bool			m_bDead;
+
+	//the sweeper's own random stream (spawn position and rotation)
+	CRandomStream	m_Rng;
 public:
-	CMinesweeper(void):m_dMinesGathered(0),
+	CMinesweeper(const CRandomStream &rng):m_dMinesGathered(0),
 					   m_dScale(CParams::iSweeperScale),
 					   m_iClosestMine(0),
-					   m_bDead(false){}
+					   m_bDead(false),
+					   m_Rng(rng){}
 	virtual ~CMinesweeper(void);
 
 	void		IncrementMinesGathered(){++m_dMinesGathered;}
@@ -16,18 +16,17 @@
 
 #include "CNeuralNet.h"
 
-//included for RandomClamped()
 #include "utils.h"
 #include <random> 
 
 /*******************************
 ** --> Neuron Constructor <-- **
 *******************************/
-Neuron::Neuron(int numberInputs) : numInputs(numberInputs), n_error(0)
+Neuron::Neuron(int numberInputs, CRandomStream &rng) : numInputs(numberInputs), n_error(0)
 {
 	for (int i = 0; i < numberInputs ; ++i) // the +1 is for the additional weight used as a bias
 	{
-		weightVector.push_back(RandomClamped()); 
+		weightVector.push_back(rng.RandomClamped()); 
 
 		//set all the previous dealta weights to 0 when neuron is initialized
 		previousDeltas.push_back(0);
@@ -37,11 +36,11 @@ Neuron::Neuron(int numberInputs) : numInputs(numberInputs), n_error(0)
 /**************************************
 ** --> Neuron Layer Constructor <-- **
 **************************************/
-NeuronLayer::NeuronLayer(int numberNeurons, int numInputPerNeuron) : numNeurons(numberNeurons)
+NeuronLayer::NeuronLayer(int numberNeurons, int numInputPerNeuron, CRandomStream &rng) : numNeurons(numberNeurons)
 {
 	for (int i = 0; i < numberNeurons; ++i)
 	{
-		neuronVector.push_back(Neuron(numInputPerNeuron));
+		neuronVector.push_back(Neuron(numInputPerNeuron, rng));
 	}
 }
 
@@ -51,7 +50,8 @@ NeuronLayer::NeuronLayer(int numberNeurons, int numInputPerNeuron) : numNeurons(
  and output layers.
 */
 CNeuralNet::CNeuralNet(uint inputLayerSize, uint hiddenLayerSize, uint outputLayerSize, double lRate, double mse_cutoff) :
-	_inputLayerSize(inputLayerSize), _hiddenLayerSize(hiddenLayerSize), _outputLayerSize(outputLayerSize), _lRate(lRate), _mse_cutoff(mse_cutoff)
+	_inputLayerSize(inputLayerSize), _hiddenLayerSize(hiddenLayerSize), _outputLayerSize(outputLayerSize), _lRate(lRate), _mse_cutoff(mse_cutoff),
+	m_Rng(CRandomService::Stream(CRandomService::Network, 0))
 	//you probably want to use an initializer list here
 {
 	/*********************************************
@@ -59,10 +59,10 @@ CNeuralNet::CNeuralNet(uint inputLayerSize, uint hiddenLayerSize, uint outputLay
 	**********************************************/
 	
 	// create hidden layer
-	layersVector.push_back(NeuronLayer(_hiddenLayerSize, _inputLayerSize));
+	layersVector.push_back(NeuronLayer(_hiddenLayerSize, _inputLayerSize, m_Rng));
 
 	// create output layer
-	layersVector.push_back(NeuronLayer(_outputLayerSize, _hiddenLayerSize));
+	layersVector.push_back(NeuronLayer(_outputLayerSize, _hiddenLayerSize, m_Rng));
 
 	// initialized the weights of the neurons in the two layers above
 	initWeights(); 
@@ -88,7 +88,7 @@ void CNeuralNet::initWeights()
 			// For each weight   
 			for (int w = 0; w < layersVector[i].neuronVector[n].numInputs; ++w)
 			{
-				layersVector[i].neuronVector[n].weightVector[w] = RandomClamped(); //RandomClamped returns a random float in the range - 1 < n < 1
+				layersVector[i].neuronVector[n].weightVector[w] = m_Rng.RandomClamped(); //RandomClamped returns a random float in the range - 1 < n < 1
 			}
 		}
 	}
@@ -101,16 +101,16 @@ void CNeuralNet::initWeights()
  (each _hidden layer node = sigmoid (sum( _weights_h_i * _inputs)) //assume the network is completely connected
  3. Repeat step 2, but this time compute the output at the output layer
 */
-void CNeuralNet::feedForward(std::vector<double> inputs) 
+void CNeuralNet::feedForward(const std::vector<double> &inputs) 
 {
-	vector<double> tempIO = inputs;
+	//the buffers keep their capacity, so after the first pass this never allocates
+	layerInputsVector.assign(inputs.begin(), inputs.end());
 
 	// For each layer --> 0 = hidden; 1 = output
 	for (int l = 0; l < 2; ++l)
 	{
 		//The output of the previous iteration is the input for the current
-		inputs = tempIO;
-		tempIO.clear();
+		if (l > 0) layerInputsVector.assign(outputsVector.begin(), outputsVector.end());
 		//Clear the output vector//
 		//because we only want the output of the last layer to be stored in the outputVector
 		outputsVector.clear();
@@ -124,15 +124,13 @@ void CNeuralNet::feedForward(std::vector<double> inputs)
 			for (int w = 0; w < layersVector[l].neuronVector[n].numInputs; ++w)
 			{
 				//       sum of the w-th input with its respective weight w
-				sumInputs += inputs[w] * layersVector[l].neuronVector[n].weightVector[w];
+				sumInputs += layerInputsVector[w] * layersVector[l].neuronVector[n].weightVector[w];
 			}
 
 			//Store the output of the neuron in the neuron
 			layersVector[l].neuronVector[n].n_output = (1 / (1 + exp(-sumInputs)));			//sigmoid function --> (1 / (1 + exp(-sumInputs)))
 			//Push the output of each neuron in the layer to the outputsVector 
 			outputsVector.push_back(layersVector[l].neuronVector[n].n_output);
-			//set temp IO for loop
-			tempIO.push_back(layersVector[l].neuronVector[n].n_output);
 		}
 	}
 }
@@ -289,7 +287,7 @@ void CNeuralNet::train(std::vector<std::vector<double>> inputs,	std::vector<std:
 Once our network is trained we can simply feed it some input though the feed forward
 method and take the maximum value as the classification
 */
-uint CNeuralNet::classify(std::vector<double> input)
+uint CNeuralNet::classify(const std::vector<double> &input)
 {
 	//Send the input to the feed forward method
 	feedForward(input);
@@ -14,6 +14,7 @@
 #include <cstring>
 #include <stdio.h>
 #include <stdint.h>
+#include "CRandom.h"
 
 typedef unsigned int uint;
 
@@ -38,7 +39,7 @@ struct Neuron
 	std::vector<double> previousDeltas ;
 
 	// Neuron Constructor
-	Neuron(int numberInputs);
+	Neuron(int numberInputs, CRandomStream &rng);
 };
 
 /************************************************
@@ -53,7 +54,7 @@ struct NeuronLayer
 	std::vector<Neuron> neuronVector;
 
 	// Neuron layer constructor
-	NeuronLayer(int numberNeurons, int numInputsPerNeuron);
+	NeuronLayer(int numberNeurons, int numInputsPerNeuron, CRandomStream &rng);
 };
 
 class CNeuralNet 
@@ -67,19 +68,22 @@ private:
 	double momentum = 0.9;
 	double MSE = 1;			// Mean Squared Error value
 	double MSEv = 1;        // Mean Squared Error value for the validation set
+
+	CRandomStream m_Rng;	// the network's own random stream for weight initialization
 		 
 	std::vector<NeuronLayer> layersVector; // Storage for each layer of neurons including the output layer	
 	std::vector<double> outputsVector; // Storage for the output layers calculated output
+	std::vector<double> layerInputsVector; // Inputs of the layer being fed forward, reused between calls
 
 protected:
-	void feedForward(std::vector<double> inputs); //you may modify this to do std::vector<double> if you want
+	void feedForward(const std::vector<double> &inputs); //you may modify this to do std::vector<double> if you want
 	void propagateErrorBackward(std::vector<double> desiredOutput, std::vector<double> inputsLayer); //you may modify this to do std::vector<double> if you want
 	double meanSquaredError(std::vector<double> desiredOutput); //you may modify this to do std::vector<double> if you want
 public:
 	CNeuralNet(uint inputLayerSize, uint hiddenLayerSize, uint outputLayerSize, double lRate, double mse_cutoff);
 	void initWeights();
 	void train(std::vector<std::vector<double>> inputs, std::vector<std::vector<double>> outputs, uint trainingSetSize); //you may modify this to do std::vector<std::vector<double> > or do boost multiarray or something else if you want
-	uint classify(std::vector<double> input); //you may modify this to do std::vector<double> if you want
+	uint classify(const std::vector<double> &input); //you may modify this to do std::vector<double> if you want
 	double getOutput(uint index) const;
 	virtual ~CNeuralNet();
 };
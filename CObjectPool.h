@@ -0,0 +1,148 @@
+#ifndef COBJECTPOOL_H
+#define COBJECTPOOL_H
+//------------------------------------------------------------------------
+//
+//	Name: CObjectPool.h
+//
+//  Desc: Struct-of-arrays storage for a controller's collision objects.
+//        The x and y positions, the types and an alive bitset each sit in
+//        one contiguous array, so there is no allocation per object and a
+//        position is one load instead of two pointer chases. Killing an
+//        object clears a bit, and reviving everything for the next
+//        iteration is a memset.
+//
+//        m_vecObjects[i] hands out a CObjectRef - a small handle with the
+//        old per-object accessors (getType, getPosition, isDead, die, ...)
+//        - so renderers and controllers can still talk to one object.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "SVector2D.h"
+#include "CCollisionObject.h"
+
+template <class T> class CObjectRef;
+
+template <class T>
+class CObjectPool
+{
+private:
+	std::vector<T>			m_vecX;
+	std::vector<T>			m_vecY;
+	std::vector<uint8_t>	m_vecType;
+
+	//bit i of word i / 64 is set while object i is alive
+	std::vector<uint64_t>	m_vecAlive;
+
+public:
+	//appends a live object, returns its index
+	int			Add(CCollisionObject::ObjectType type, SVector2D<T> position)
+	{
+		int index = (int)m_vecType.size();
+
+		m_vecX.push_back(position.x);
+		m_vecY.push_back(position.y);
+		m_vecType.push_back((uint8_t)type);
+
+		if ((size_t)index / 64 == m_vecAlive.size()) m_vecAlive.push_back(0);
+		Revive(index);
+
+		return index;
+	}
+
+	//removes every object
+	void		Clear()
+	{
+		m_vecX.clear();
+		m_vecY.clear();
+		m_vecType.clear();
+		m_vecAlive.clear();
+	}
+
+	size_t		size()const{return m_vecType.size();}
+
+	//bytes the pool holds its objects in
+	size_t		Bytes()const
+	{
+		return (m_vecX.size() + m_vecY.size()) * sizeof(T) + m_vecType.size() + m_vecAlive.size() * sizeof(uint64_t);
+	}
+
+	//handle to one object
+	CObjectRef<T>	operator[](int index);
+
+	//-------------------per object accessors
+	CCollisionObject::ObjectType	Type(int index)const{return (CCollisionObject::ObjectType)m_vecType[index];}
+	void		SetType(int index, CCollisionObject::ObjectType type){m_vecType[index] = (uint8_t)type;}
+
+	T			X(int index)const{return m_vecX[index];}
+	T			Y(int index)const{return m_vecY[index];}
+	SVector2D<T>	Position(int index)const{return SVector2D<T>(m_vecX[index], m_vecY[index]);}
+	void		SetPosition(int index, SVector2D<T> position)
+	{
+		m_vecX[index] = position.x;
+		m_vecY[index] = position.y;
+	}
+
+	bool		Alive(int index)const{return (m_vecAlive[index / 64] >> (index % 64)) & 1;}
+	void		Kill(int index){m_vecAlive[index / 64] &= ~((uint64_t)1 << (index % 64));}
+	void		Revive(int index){m_vecAlive[index / 64] |= (uint64_t)1 << (index % 64);}
+
+	//replaces the positions and types of all the objects (as many as the
+	//pool holds) and brings them all back to life
+	void		Assign(const T* x, const T* y, const uint8_t* types)
+	{
+		if (m_vecType.empty()) return;
+
+		memcpy(&m_vecX[0], x, m_vecX.size() * sizeof(T));
+		memcpy(&m_vecY[0], y, m_vecY.size() * sizeof(T));
+		memcpy(&m_vecType[0], types, m_vecType.size());
+
+		ReviveAll();
+	}
+
+	//brings every object back to life for the next iteration
+	void		ReviveAll()
+	{
+		if (m_vecAlive.empty()) return;
+
+		memset(&m_vecAlive[0], 0xFF, m_vecAlive.size() * sizeof(uint64_t));
+
+		//keep the bits past the last object clear
+		if (size() % 64) m_vecAlive.back() = ((uint64_t)1 << (size() % 64)) - 1;
+	}
+};
+
+//------------------------------------------------------------------------
+//	a reference to one object of a pool. It is only valid while the pool
+//	is not added to or cleared
+//------------------------------------------------------------------------
+template <class T>
+class CObjectRef : public CCollisionObject
+{
+private:
+	CObjectPool<T>*		m_pPool;
+	int					m_iIndex;
+
+public:
+	CObjectRef(CObjectPool<T>* pool, int index):m_pPool(pool), m_iIndex(index){}
+
+	ObjectType		getType()const{return m_pPool->Type(m_iIndex);}
+	void			setType(ObjectType objectType){m_pPool->SetType(m_iIndex, objectType);}
+
+	SVector2D<T>	getPosition()const{return m_pPool->Position(m_iIndex);}
+	void			setPosition(SVector2D<T> position){m_pPool->SetPosition(m_iIndex, position);}
+
+	bool			isDead()const{return !m_pPool->Alive(m_iIndex);}
+	void			die(){m_pPool->Kill(m_iIndex);}
+	void			Reset(){m_pPool->Revive(m_iIndex);}
+};
+
+template <class T>
+inline CObjectRef<T> CObjectPool<T>::operator[](int index)
+{
+	return CObjectRef<T>(this, index);
+}
+
+#endif
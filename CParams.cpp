@@ -24,6 +24,8 @@ double CParams::dHalfPi             = dPi / 2;
 double CParams::dTwoPi              = dPi * 2;
 int CParams::WindowWidth            = 400;
 int CParams::WindowHeight           = 400;
+int CParams::WorldWidth             = 400;
+int CParams::WorldHeight            = 400;
 int CParams::iFramesPerSecond       = 0;
 double CParams::dMaxTurnRate        = 0;
 double CParams::dMaxSpeed           = 0;
@@ -39,9 +41,43 @@ int CParams::iNumCopiesElite        = 0;
 bool CParams::bDiscreteGrid			= false;
 int CParams::iGridCellDim			= 10;
 std::string CParams::sTrainingFilename	= "training.txt";
+int CParams::iRandomSeed			= 0;
+bool CParams::bTiledQTable			= false;
+bool CParams::bSharedQTable			= false;
+double CParams::dTargetMines		= 0;
+double CParams::dLearningRate		= 0.75;
+double CParams::dDiscountFactor		= 0.6;
+double CParams::dEpsilon			= 0.5;
+std::string CParams::sCheckpointFilename	= "qtable.ckpt";
+int CParams::iCheckpointInterval	= 0;
+bool CParams::bWarmStart			= false;
+double CParams::dLambda				= 0;
+double CParams::dTraceThreshold		= 0.01;
+int CParams::iReplayCapacity		= 0;
+int CParams::iReplayBatchSize		= 256;
+double CParams::dReplayRatio		= 1;
+bool CParams::bPlanner				= false;
+int CParams::iPlanningBackups		= 100;
+double CParams::dPlanningThreshold	= 0.01;
+bool CParams::bEvaluate				= false;
+bool CParams::bSharedPolicy			= false;
+int CParams::iStateEncoding			= 0;
+int CParams::iStateCapacity			= 65536;
+bool CParams::bBitboardWorld		= false;
+bool CParams::bRecordTrace			= false;
+std::string CParams::sTraceFilename	= "trace.bin";
+int CParams::iReplayIteration		= -1;
+std::string CParams::sStatsPrefix	= "stats";
+int CParams::iStatsFormat			= 0;
+int CParams::iStepThreads			= 1;
+int CParams::iWorldCellsX			= 0;
+int CParams::iWorldCellsY			= 0;
+bool CParams::bUseScenarios			= false;
+std::string CParams::sScenarioFilename	= "scenarios.bin";
+bool CParams::bProfileUpdate			= false;
 //this function loads in the parameters from a given file name. Returns
 //false if there is a problem opening the file.
-bool CParams::LoadInParameters(char* szFileName)
+bool CParams::LoadInParameters(const char* szFileName)
 {
   using namespace std;	
   ifstream grab(szFileName);
@@ -86,8 +122,88 @@ bool CParams::LoadInParameters(char* szFileName)
   grab >> ParamDescription;  
   getline(grab,sTrainingFilename);
   sTrainingFilename = trim(sTrainingFilename);
+  grab >> ParamDescription;
+  grab >> bTiledQTable;
+  grab >> ParamDescription;
+  grab >> bSharedQTable;
+  grab >> ParamDescription;
+  grab >> dTargetMines;
+  grab >> ParamDescription;
+  grab >> iRandomSeed;
+  grab >> ParamDescription;
+  grab >> dLearningRate;
+  grab >> ParamDescription;
+  grab >> dDiscountFactor;
+  grab >> ParamDescription;
+  grab >> dEpsilon;
+  grab >> ParamDescription;
+  getline(grab,sCheckpointFilename);
+  sCheckpointFilename = trim(sCheckpointFilename);
+  grab >> ParamDescription;
+  grab >> iCheckpointInterval;
+  grab >> ParamDescription;
+  grab >> bWarmStart;
+  grab >> ParamDescription;
+  grab >> dLambda;
+  grab >> ParamDescription;
+  grab >> dTraceThreshold;
+  grab >> ParamDescription;
+  grab >> iReplayCapacity;
+  grab >> ParamDescription;
+  grab >> iReplayBatchSize;
+  grab >> ParamDescription;
+  grab >> dReplayRatio;
+  grab >> ParamDescription;
+  grab >> bPlanner;
+  grab >> ParamDescription;
+  grab >> iPlanningBackups;
+  grab >> ParamDescription;
+  grab >> dPlanningThreshold;
+  grab >> ParamDescription;
+  grab >> bEvaluate;
+  grab >> ParamDescription;
+  grab >> bSharedPolicy;
+  grab >> ParamDescription;
+  grab >> iStateEncoding;
+  grab >> ParamDescription;
+  grab >> iStateCapacity;
+  grab >> ParamDescription;
+  grab >> bBitboardWorld;
+  grab >> ParamDescription;
+  grab >> bRecordTrace;
+  grab >> ParamDescription;
+  getline(grab,sTraceFilename);
+  sTraceFilename = trim(sTraceFilename);
+  grab >> ParamDescription;
+  grab >> iReplayIteration;
+  grab >> ParamDescription;
+  getline(grab,sStatsPrefix);
+  sStatsPrefix = trim(sStatsPrefix);
+  grab >> ParamDescription;
+  grab >> iStatsFormat;
+  grab >> ParamDescription;
+  grab >> iStepThreads;
+  grab >> ParamDescription;
+  grab >> iWorldCellsX;
+  grab >> ParamDescription;
+  grab >> iWorldCellsY;
+  grab >> ParamDescription;
+  grab >> bUseScenarios;
+  grab >> ParamDescription;
+  getline(grab,sScenarioFilename);
+  sScenarioFilename = trim(sScenarioFilename);
+  grab >> ParamDescription;
+  grab >> bProfileUpdate;
+
+  SetWorldSize();
   return true;
 }
+
+void CParams::SetWorldSize()
+{
+  WorldWidth = iWorldCellsX > 0 ? iWorldCellsX * iGridCellDim : WindowWidth;
+  WorldHeight = iWorldCellsY > 0 ? iWorldCellsY * iGridCellDim : WindowHeight;
+}
  
 
 
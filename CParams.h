@@ -13,7 +13,7 @@
 //
 //------------------------------------------------------------------------
 #include <fstream>
-#include <windows.h>
+#include "Platform.h"
 #include <string>
 #include <algorithm>
 #include <functional> 
@@ -33,6 +33,11 @@ public:
   static int    WindowWidth;
   static int    WindowHeight;
 
+  //size of the discrete world in pixels: iWorldCellsX by iWorldCellsY
+  //cells, or the window when those are 0 (see SetWorldSize)
+  static int    WorldWidth;
+  static int    WorldHeight;
+
   static int    iFramesPerSecond;
   
   //--------------------------------------used to define the sweepers
@@ -67,6 +72,95 @@ public:
   static int		  iGridCellDim;
   static std::string  sTrainingFilename;
 
+  //master seed of the random number service (0 = seed from the clock)
+  static int    iRandomSeed;
+
+  //--------------------------------------Q-learning parameters
+
+  //store the Q tables in Z-order tiles instead of row major
+  static bool   bTiledQTable;
+
+  //all the sweepers learn in one shared table instead of one table each. It
+  //takes 1/iNumSweepers of the memory and learns faster early on, but with
+  //the default rewards it settles on dodging supermines over gathering mines
+  static bool   bSharedQTable;
+
+  //average mines per sweeper at which the time to target is reported (0 = off)
+  static double dTargetMines;
+
+  //learning rate, discount factor and exploration rate of the Q function
+  static double dLearningRate;
+  static double dDiscountFactor;
+  static double dEpsilon;
+
+  //Q(lambda) trace decay (0 = one-step Q-learning) and the eligibility
+  //below which a trace is dropped from a sweeper's active list
+  static double dLambda;
+  static double dTraceThreshold;
+
+  //experience replay: ring capacity in transitions (0 = off), transitions
+  //per replayed batch and replayed transitions per new transition
+  static int    iReplayCapacity;
+  static int    iReplayBatchSize;
+  static double dReplayRatio;
+
+  //background prioritized-sweeping planner: on/off, backups per tick and
+  //the TD error below which a pair is not queued
+  static bool   bPlanner;
+  static int    iPlanningBackups;
+  static double dPlanningThreshold;
+
+  //inference only: compile the learned tables into a frozen greedy policy
+  //map and step the sweepers from it, one map per sweeper or one shared map
+  static bool   bEvaluate;
+  static bool   bSharedPolicy;
+
+  //what a Q-learning state is (0 = grid position, 1 = the 3x3 block of
+  //objects around the sweeper plus its heading) and, for encodings other
+  //than the position, how many states the hashed table keeps
+  static int    iStateEncoding;
+  static int    iStateCapacity;
+
+  //discrete world stored as bitboards (a bit per cell for each object type)
+  //instead of per cell object chains - same results, a few bits per cell.
+  //Worlds of more than MAX_CHAIN_INDEX_CELLS cells always use them
+  static bool   bBitboardWorld;
+
+  //record every episode to a trace file, and the iteration the GUI replays
+  //from it ('P', -1 = the last one recorded)
+  static bool   bRecordTrace;
+  static std::string  sTraceFilename;
+  static int    iReplayIteration;
+
+  //per iteration stats file of the discrete world: <prefix>-<seed> plus
+  //.csv (format 0) or .bin (format 1, raw records). A run whose file is
+  //already there writes <prefix>-<seed>-1, -2, ... instead
+  static std::string  sStatsPrefix;
+  static int    iStatsFormat;
+
+  //threads each tick's sweepers are stepped on (0 or 1 = serial). Any
+  //number gives the same results
+  static int    iStepThreads;
+
+  //discrete world size in cells, independent of the window (0 = as many
+  //cells as fit in the window). The window then shows part of the world
+  static int    iWorldCellsX;
+  static int    iWorldCellsY;
+
+  //start the episodes from the layouts of a scenario bank, in turn,
+  //instead of random worlds (trainer --make-scenarios writes one)
+  static bool   bUseScenarios;
+  static std::string  sScenarioFilename;
+
+  //print what Update() costs per tick at the end of every iteration
+  static bool   bProfileUpdate;
+
+  //Q table checkpoint file, how often it is saved (in iterations, 0 = only
+  //on demand) and whether a run starts from it
+  static std::string  sCheckpointFilename;
+  static int    iCheckpointInterval;
+  static bool   bWarmStart;
+
   //ctor
   CParams()
   {
@@ -77,7 +171,19 @@ public:
 
   }
 
-  bool LoadInParameters(char* szFileName);
+  //loads the parameters from the given ini file instead
+  explicit CParams(const char* szFileName)
+  {
+    if(!LoadInParameters(szFileName))
+    {
+      MessageBox(NULL, "Cannot find ini file!", "Error", 0);
+    }
+  }
+
+  bool LoadInParameters(const char* szFileName);
+
+  //works out WorldWidth and WorldHeight from iWorldCellsX/Y and the window
+  static void SetWorldSize();
 };
 
 
@@ -0,0 +1,225 @@
+#include "CPlanner.h"
+#include "CActionSelector.h"
+#include <math.h>
+
+template <class Value>
+const uint32_t CPlanner<Value>::NONE;
+
+template <class Value>
+CPlanner<Value>::CPlanner(): m_pTable(NULL),
+							 m_dLearningRate(0),
+							 m_dDiscount(0),
+							 m_dThreshold(0),
+							 m_iBackupsPerTick(0),
+							 m_iCredit(0),
+							 m_bStop(false),
+							 m_iBackups(0)
+{
+}
+
+template <class Value>
+CPlanner<Value>::~CPlanner()
+{
+	Stop();
+}
+
+template <class Value>
+void CPlanner<Value>::Start(CQTable<Value> &table, double learningRate, double discount,
+							double threshold, uint backupsPerTick)
+{
+	Stop();
+
+	m_pTable = &table;
+	m_dLearningRate = learningRate;
+	m_dDiscount = discount;
+	m_dThreshold = threshold;
+	m_iBackupsPerTick = backupsPerTick;
+
+	size_t cells = (size_t)table.NumTables() * table.CellsPerTable();
+
+	m_vecModelNext.assign(cells * NUM_ACTIONS, NONE);
+	m_vecModelReward.assign(cells * NUM_ACTIONS, 0);
+	m_vecPredHead.assign(cells, NONE);
+	m_vecPredNext.assign(cells * NUM_ACTIONS, NONE);
+	m_Queue = std::priority_queue<std::pair<float, uint32_t> >();
+
+	m_vecPending.clear();
+	m_vecInbox.clear();
+	m_iCredit = 0;
+	m_bStop = false;
+	m_iBackups.store(0);
+
+	m_Thread = std::thread(&CPlanner<Value>::Run, this);
+}
+
+template <class Value>
+void CPlanner<Value>::Stop()
+{
+	if (!m_Thread.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bStop = true;
+	}
+	m_Wake.notify_one();
+
+	m_Thread.join();
+}
+
+template <class Value>
+void CPlanner<Value>::EndTick()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_vecInbox.insert(m_vecInbox.end(), m_vecPending.begin(), m_vecPending.end());
+
+		m_iCredit += m_iBackupsPerTick;
+		if (m_iCredit > MAX_CARRIED_TICKS * m_iBackupsPerTick) m_iCredit = MAX_CARRIED_TICKS * m_iBackupsPerTick;
+	}
+	m_vecPending.clear();
+
+	m_Wake.notify_one();
+}
+
+//--------------------------------Priority()-------------------------------
+//
+//	|r + discount * max Q(s') - Q(s,a)| for the modelled outcome of a pair
+//
+//-------------------------------------------------------------------------
+template <class Value>
+double CPlanner<Value>::Priority(uint32_t entry) const
+{
+	uint cellsPerTable = m_pTable->CellsPerTable();
+	uint table = entry / (cellsPerTable * NUM_ACTIONS);
+	uint cell = (entry / NUM_ACTIONS) % cellsPerTable;
+	uint action = entry % NUM_ACTIONS;
+
+	double nextValues[NUM_ACTIONS];
+	m_pTable->Load(table, m_vecModelNext[entry], nextValues);
+
+	return fabs(m_vecModelReward[entry] + m_dDiscount * MaxValue(nextValues) - m_pTable->Get(table, cell, action));
+}
+
+//queues a pair if its value is off by more than the threshold
+template <class Value>
+void CPlanner<Value>::Enqueue(uint32_t entry)
+{
+	if (m_Queue.size() >= MAX_QUEUED) return;
+
+	double priority = Priority(entry);
+
+	if (priority > m_dThreshold) m_Queue.push(std::make_pair((float)priority, entry));
+}
+
+//---------------------------------Learn()---------------------------------
+//
+//	records a real transition in the model and queues the pair
+//
+//-------------------------------------------------------------------------
+template <class Value>
+void CPlanner<Value>::Learn(const STransition &transition)
+{
+	uint cellsPerTable = m_pTable->CellsPerTable();
+	uint32_t entry = ((uint32_t)transition.table * cellsPerTable + transition.cell) * NUM_ACTIONS + transition.action;
+
+	//the first time a pair is seen it becomes a predecessor of where it leads. The world is
+	//deterministic, so a pair keeps leading to the same cell
+	if (m_vecModelNext[entry] == NONE)
+	{
+		uint32_t nextCell = transition.table * cellsPerTable + transition.nextCell;
+
+		m_vecPredNext[entry] = m_vecPredHead[nextCell];
+		m_vecPredHead[nextCell] = entry;
+	}
+
+	m_vecModelNext[entry] = transition.nextCell;
+	m_vecModelReward[entry] = transition.reward;
+
+	Enqueue(entry);
+}
+
+//---------------------------------Backup()--------------------------------
+//
+//	one-step backup of a modelled pair, then queue every predecessor of its
+//	state whose value is now off by more than the threshold
+//
+//-------------------------------------------------------------------------
+template <class Value>
+void CPlanner<Value>::Backup(uint32_t entry)
+{
+	uint cellsPerTable = m_pTable->CellsPerTable();
+	uint table = entry / (cellsPerTable * NUM_ACTIONS);
+	uint cell = (entry / NUM_ACTIONS) % cellsPerTable;
+	uint action = entry % NUM_ACTIONS;
+
+	double nextValues[NUM_ACTIONS];
+	m_pTable->Load(table, m_vecModelNext[entry], nextValues);
+
+	double value = m_pTable->Get(table, cell, action);
+	double delta = m_vecModelReward[entry] + m_dDiscount * MaxValue(nextValues) - value;
+
+	m_pTable->Set(table, cell, action, value + m_dLearningRate * delta);
+	m_iBackups.fetch_add(1, std::memory_order_relaxed);
+
+	for (uint32_t pred = m_vecPredHead[table * cellsPerTable + cell]; pred != NONE; pred = m_vecPredNext[pred])
+	{
+		Enqueue(pred);
+	}
+}
+
+//----------------------------------Run()----------------------------------
+//
+//	planner thread: sleep until there are transitions to learn or budget
+//	and queued work, then take both and work outside the lock
+//
+//-------------------------------------------------------------------------
+template <class Value>
+void CPlanner<Value>::Run()
+{
+	std::vector<STransition> transitions;
+
+	while (true)
+	{
+		uint budget = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			while (!m_bStop && m_vecInbox.empty() && (m_iCredit == 0 || m_Queue.empty()))
+			{
+				m_Wake.wait(lock);
+			}
+
+			if (m_bStop) return;
+
+			transitions.swap(m_vecInbox);
+			budget = m_iCredit;
+			m_iCredit = 0;
+		}
+
+		for (size_t i = 0; i < transitions.size(); ++i)
+		{
+			Learn(transitions[i]);
+		}
+		transitions.clear();
+
+		while (budget > 0 && !m_Queue.empty())
+		{
+			uint32_t entry = m_Queue.top().second;
+			m_Queue.pop();
+
+			//stale copy - an earlier backup already fixed this pair
+			if (Priority(entry) <= m_dThreshold) continue;
+
+			Backup(entry);
+			--budget;
+		}
+	}
+}
+
+//the value types the controller is built with
+template class CPlanner<int>;
+template class CPlanner<float>;
+template class CPlanner<double>;
+template class CPlanner<SFixed16>;
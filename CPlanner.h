@@ -0,0 +1,132 @@
+#ifndef CPLANNER_H
+#define CPLANNER_H
+//------------------------------------------------------------------------
+//
+//	Name: CPlanner.h
+//
+//  Desc: Background Dyna-Q planner using prioritized sweeping. The
+//        simulation thread hands every real transition to the planner; the
+//        planner thread keeps a model of the last observed outcome (reward
+//        and next cell) of each state-action pair and backs values up from
+//        a priority queue ordered by the size of their TD error, pushing
+//        the predecessors of every updated state as it goes.
+//
+//        Transitions cross threads through a mutex protected inbox once
+//        per tick. The model and the queue belong to the planner thread
+//        alone, and its backups go straight into the Q table through the
+//        table's relaxed atomics (the same lock-free rule as the shared
+//        table), so the simulation never waits on the planner.
+//
+//        The compute budget is a number of backups per simulated tick.
+//        Unused budget carries over for a few ticks at most, so a planner
+//        that falls behind never builds up an unbounded backlog.
+//
+//        Backups run concurrently with the simulation, so a run with the
+//        planner on is not bit reproducible.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <queue>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdint.h>
+#include "CQTable.h"
+
+template <class Value>
+class CPlanner
+{
+private:
+	struct STransition
+	{
+		uint	table;
+		uint	cell;
+		uint	action;
+		float	reward;
+		uint	nextCell;
+	};
+
+	//marks a model entry that has never been observed / the end of a predecessor list
+	static const uint32_t NONE = 0xFFFFFFFF;
+
+	//ticks of unused budget the planner may carry over
+	static const uint MAX_CARRIED_TICKS = 4;
+
+	//bound on the queue (duplicates included); pushes beyond it are dropped
+	static const size_t MAX_QUEUED = 1 << 20;
+
+	CQTable<Value>*			m_pTable;
+	double					m_dLearningRate;
+	double					m_dDiscount;
+	double					m_dThreshold;
+	uint					m_iBackupsPerTick;
+
+	//------------------------------------planner thread only
+	//model, indexed like the Q arena: last next cell and reward of each pair
+	std::vector<uint32_t>	m_vecModelNext;
+	std::vector<float>		m_vecModelReward;
+
+	//predecessors of each arena cell, as an intrusive list through the model entries
+	std::vector<uint32_t>	m_vecPredHead;
+	std::vector<uint32_t>	m_vecPredNext;
+
+	//(priority, model entry) - an entry can be queued more than once, stale
+	//copies are skipped when their recomputed priority is below the threshold
+	std::priority_queue<std::pair<float, uint32_t> >	m_Queue;
+
+	//------------------------------------simulation thread only
+	std::vector<STransition>	m_vecPending;
+
+	//------------------------------------shared, guarded by m_Mutex
+	std::vector<STransition>	m_vecInbox;
+	uint						m_iCredit;
+	bool						m_bStop;
+
+	std::mutex					m_Mutex;
+	std::condition_variable		m_Wake;
+	std::thread					m_Thread;
+
+	//backups done so far (read by the simulation thread for reporting)
+	std::atomic<uint64_t>		m_iBackups;
+
+	void		Run();
+
+	//absolute TD error of a model entry against the current table
+	double		Priority(uint32_t entry) const;
+
+	void		Enqueue(uint32_t entry);
+	void		Learn(const STransition &transition);
+	void		Backup(uint32_t entry);
+
+	CPlanner(const CPlanner&);
+	CPlanner& operator=(const CPlanner&);
+
+public:
+	CPlanner();
+	~CPlanner();
+
+	//builds an empty model for the table and starts the planner thread
+	void		Start(CQTable<Value> &table, double learningRate, double discount,
+					  double threshold, uint backupsPerTick);
+
+	//stops and joins the planner thread
+	void		Stop();
+
+	bool		Running()const{return m_Thread.joinable();}
+
+	//queues a real transition (simulation thread)
+	void		Observe(uint table, uint cell, uint action, float reward, uint nextCell)
+	{
+		STransition transition = {table, cell, action, reward, nextCell};
+		m_vecPending.push_back(transition);
+	}
+
+	//hands the tick's transitions and budget to the planner (simulation thread)
+	void		EndTick();
+
+	uint64_t	Backups()const{return m_iBackups.load(std::memory_order_relaxed);}
+};
+
+#endif
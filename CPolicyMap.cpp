@@ -0,0 +1,69 @@
+#include "CPolicyMap.h"
+#include "CActionSelector.h"
+
+CPolicyMap::CPolicyMap(): m_iNumMaps(0),
+						  m_iGridX(0),
+						  m_iGridY(0)
+{
+}
+
+//---------------------------------Compile()-------------------------------
+//
+//	argmax of each cell's values; equal best values are decided by a draw
+//	so that unvisited (all zero) cells do not all point the same way
+//
+//-------------------------------------------------------------------------
+template <class Value>
+void CPolicyMap::Compile(const CQTable<Value> &table, uint gridX, uint gridY, bool shared, CRandomStream &rng)
+{
+	m_iNumMaps = shared ? 1 : table.NumTables();
+	m_iGridX = gridX;
+	m_iGridY = gridY;
+
+	m_vecActions.assign(((size_t)m_iNumMaps * gridX * gridY + 3) / 4, 0);
+
+	for (uint map = 0; map < m_iNumMaps; ++map)
+	{
+		for (uint x = 0; x < gridX; ++x)
+		{
+			for (uint y = 0; y < gridY; ++y)
+			{
+				uint cell = table.CellIndex(x, y);
+
+				double values[NUM_ACTIONS] = {0};
+
+				//a shared map follows the sum of every sweeper's values
+				uint first = shared ? 0 : map;
+				uint last = shared ? table.NumTables() : map + 1;
+
+				for (uint t = first; t < last; ++t)
+				{
+					double tableValues[NUM_ACTIONS];
+					table.Load(t, cell, tableValues);
+
+					for (uint a = 0; a < NUM_ACTIONS; ++a) values[a] += tableValues[a];
+				}
+
+				double best = MaxValue(values);
+
+				uint ties[NUM_ACTIONS];
+				uint numTies = 0;
+
+				for (uint a = 0; a < NUM_ACTIONS; ++a)
+				{
+					if (values[a] == best) ties[numTies++] = a;
+				}
+
+				uint action = numTies == 1 ? ties[0] : ties[rng.RandInt(0, numTies - 1)];
+
+				SetAction(map, x * gridY + y, action);
+			}
+		}
+	}
+}
+
+//the value types the controller is built with
+template void CPolicyMap::Compile<int>(const CQTable<int>&, uint, uint, bool, CRandomStream&);
+template void CPolicyMap::Compile<float>(const CQTable<float>&, uint, uint, bool, CRandomStream&);
+template void CPolicyMap::Compile<double>(const CQTable<double>&, uint, uint, bool, CRandomStream&);
+template void CPolicyMap::Compile<SFixed16>(const CQTable<SFixed16>&, uint, uint, bool, CRandomStream&);
@@ -0,0 +1,63 @@
+#ifndef CPOLICYMAP_H
+#define CPOLICYMAP_H
+//------------------------------------------------------------------------
+//
+//	Name: CPolicyMap.h
+//
+//  Desc: A trained Q table compiled down to its greedy policy: one 2 bit
+//        action per cell, four cells to a byte, one map per sweeper or a
+//        single shared map. A 41x41 grid takes 421 bytes per map, so the
+//        maps of a whole population stay in L1/L2 and an evaluation step
+//        is a shift and a mask instead of a Q value lookup and an argmax.
+//
+//        Cells are indexed like CDiscController::CellIndex (x * gridY + y).
+//        Ties between equal best values are broken once, at compile time,
+//        from the given random stream.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <stdint.h>
+#include "CQTable.h"
+#include "CRandom.h"
+
+class CPolicyMap
+{
+private:
+	std::vector<uint8_t>	m_vecActions;
+
+	uint					m_iNumMaps;
+	uint					m_iGridX;
+	uint					m_iGridY;
+
+	void		SetAction(uint map, uint cell, uint action)
+	{
+		size_t index = (size_t)map * m_iGridX * m_iGridY + cell;
+		uint shift = (index & 3) * 2;
+
+		m_vecActions[index >> 2] = (uint8_t)((m_vecActions[index >> 2] & ~(3 << shift)) | (action << shift));
+	}
+
+public:
+	CPolicyMap();
+
+	//compiles the greedy policy of every table into its own map, or (shared)
+	//of the sum of all the tables into a single map
+	template <class Value>
+	void		Compile(const CQTable<Value> &table, uint gridX, uint gridY, bool shared, CRandomStream &rng);
+
+	//the action of map (sweeper) at a cell
+	uint		Action(uint map, uint cell) const
+	{
+		size_t index = (size_t)map * m_iGridX * m_iGridY + cell;
+
+		return (m_vecActions[index >> 2] >> ((index & 3) * 2)) & 3;
+	}
+
+	//the map a sweeper follows
+	uint		MapOf(uint sweeper)const{return m_iNumMaps == 1 ? 0 : sweeper;}
+
+	uint		NumMaps()const{return m_iNumMaps;}
+	size_t		Bytes()const{return m_vecActions.size();}
+};
+
+#endif
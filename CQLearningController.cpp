@@ -14,144 +14,231 @@ for a detailed discussion on Q Learning
 */
 #include "CQLearningController.h"
 #include <stdlib.h>
-#include <time.h>
+#include <fstream>
 
-/////////////////////////////////
-//CONSTRUCTORS FOR THE Q TABLE//
 ///////////////////////////////
-Action::Action(ROTATION_DIRECTION a) : action(a){}
-
-State::State()
-{
-	stateAction.push_back(Action(NORTH)); // = 1
-	stateAction.push_back(Action(SOUTH)); // = 3
-	stateAction.push_back(Action(EAST)); // = 0
-	stateAction.push_back(Action(WEST)); // = 2
-}
-
+//CONSTRUCTOR FOR THE SWEEPER//
+/////////////////////////////
 Sweeper::Sweeper(){}
 /////////////////////////////////////////////////////
 
 
-CQLearningController::CQLearningController(HWND hwndMain):
+template <class Value>
+CQLearningControllerT<Value>::CQLearningControllerT(HWND hwndMain):
 	CDiscController(hwndMain),
-	_grid_size_x(CParams::WindowWidth / CParams::iGridCellDim + 1),
-	_grid_size_y(CParams::WindowHeight / CParams::iGridCellDim + 1)
+	_grid_size_x(CParams::WorldWidth / CParams::iGridCellDim + 1),
+	_grid_size_y(CParams::WorldHeight / CParams::iGridCellDim + 1)
 {
 }
 /**
- The update method should allocate a Q table for each sweeper (this can
- be allocated in one shot - use an offset to store the tables one after the other)
-
- You can also use a boost multiarray if you wish
+ The Q tables of all the sweepers are allocated in one shot: the arena stores the tables
+ one after the other, so sweeper i's table starts at offset i * CellsPerTable() * NUM_ACTIONS
 */
-void CQLearningController::InitializeLearningAlgorithm(void)
+template <class Value>
+void CQLearningControllerT<Value>::InitializeLearningAlgorithm(void)
 {
-	//For each sweeper...
-	for (int i = 0; i < CParams::iNumSweepers; i++)
+	CDiscController::InitializeLearningAlgorithm(); //call the parent's learning algorithm initialization
+
+	learningRate = CParams::dLearningRate;
+	discountFactor = CParams::dDiscountFactor;
+	epsilon = CParams::dEpsilon;
+	lambda = CParams::dLambda;
+	traceThreshold = CParams::dTraceThreshold;
+
+	//experience replay is on when the ring has a capacity
+	replay.Allocate(CParams::iReplayCapacity);
+	replayRng = CRandomService::Stream(CRandomService::Replay, 0);
+	replayBatchSize = CParams::iReplayBatchSize;
+	replayRatio = CParams::dReplayRatio;
+	replayCredit = 0;
+
+	//in shared mode every sweeper reads and writes table 0
+	sharedTable = CParams::bSharedQTable;
+
+	stateEncoding = (StateEncoding)CParams::iStateEncoding;
+
+	if (stateEncoding == PositionState)
+	{
+		qTable.Allocate(sharedTable ? 1 : CParams::iNumSweepers, _grid_size_x, _grid_size_y,
+						CParams::bTiledQTable ? CQTableShape::ZOrderTiled : CQTableShape::RowMajor);
+	}
+	else
 	{
-		Sweeper tempSweeper;
+		//hashed states: one row of iStateCapacity cells per table, whatever the size of the world.
+		//The cells a tick looks up (two per sweeper) are pinned, so at least one more is needed
+		uint capacity = CParams::iStateCapacity > 0 ? CParams::iStateCapacity : 1;
+		uint minCapacity = 2 * CParams::iNumSweepers + 1;
 
-		//For each x coord (column)...
-		for (int j = 0; j < _grid_size_x; j++)
+		if (capacity < minCapacity)
 		{
-			//create a vector for a column of the qTable
-			std::vector<State> qTableCol;
+			std::cout << "State index: " << capacity << " states is too few for " << CParams::iNumSweepers
+					  << " sweepers, using " << minCapacity << std::endl;
+			capacity = minCapacity;
+		}
 
-			//For each y coord (row)...
-			for (int k = 0; k < _grid_size_y; k++)
-			{
-				//Add state struct to each row in the column
-				qTableCol.push_back(State());
-			}
-			//Add the column to the sweepers Q table
-			tempSweeper.qTable.push_back(qTableCol);
+		stateIndex.Allocate(capacity);
+		qTable.Allocate(sharedTable ? 1 : CParams::iNumSweepers, capacity, 1, CQTableShape::RowMajor);
+
+		std::cout << "State index: local view encoding, " << capacity << " states, "
+				  << stateIndex.NumSlots() << " slots, " << stateIndex.Bytes() << " bytes" << std::endl;
+	}
+	lookupTime = 0;
+	lookupCount = 0;
+
+	sweepersVector.assign(CParams::iNumSweepers, Sweeper());
+
+	//exploration and tie-breaking draws for the whole batch come from one policy stream
+	policyRng = CRandomService::Stream(CRandomService::Policy, 0);
+
+	std::cout << "Q table: " << qTable.NumTables() << (sharedTable ? " shared table, " : " tables, ")
+			  << CQTable<Value>::Traits::Name() << " values, "
+			  << qTable.Bytes() << " bytes, " << qTable.BytesPerState() << " bytes per state" << std::endl;
+
+	//carry on from the last checkpoint instead of empty tables (checkpoints hold
+	//no state index, so only position encoded tables can be restored)
+	checkpointRejected = false;
+
+	if (CParams::bWarmStart && stateEncoding == PositionState)
+	{
+		double loadStart = HighResTime();
+
+		if (qTable.LoadCheckpoint(CParams::sCheckpointFilename.c_str()))
+		{
+			std::cout << "Warm start from " << CParams::sCheckpointFilename << " ("
+					  << (HighResTime() - loadStart) * 1e3 << " ms)" << std::endl;
 		}
-		//Add the temporary sweeper to the vecotr of sweepers
-		sweepersVector.push_back(tempSweeper);
+		else if (std::ifstream(CParams::sCheckpointFilename.c_str()))
+		{
+			//the file is there but does not fit these tables - keep it for a run that it does fit
+			checkpointRejected = true;
+
+			std::cout << "Checkpoint " << CParams::sCheckpointFilename << " does not fit these tables,"
+					  << " starting from empty tables and not saving over it" << std::endl;
+		}
+		else
+		{
+			std::cout << "No checkpoint in " << CParams::sCheckpointFilename
+					  << ", starting from empty tables" << std::endl;
+		}
+	}
+
+	//evaluation runs start straight from the (warm started) tables
+	evaluating = false;
+	SetPolicy(NULL);
+	if (CParams::bEvaluate) EvaluationToggle();
+
+	//the planner starts last, once the table holds its initial values. Its model takes a pair to
+	//always lead to the same cell, which only the position encoding guarantees
+	if (CParams::bPlanner && stateEncoding != PositionState)
+	{
+		std::cout << "The planner needs the position state encoding, planning is off" << std::endl;
 	}
+	else if (CParams::bPlanner)
+	{
+		planner.Start(qTable, learningRate, discountFactor, CParams::dPlanningThreshold, CParams::iPlanningBackups);
+		plannerBackupsReported = 0;
+
+		std::cout << "Planner: " << CParams::iPlanningBackups << " backups per tick" << std::endl;
+	}
+
+	startTime = HighResTime();
 }
 /**
  The immediate reward function. This computes a reward upon achieving the goal state of
  collecting all the mines on the field. It may also penalize movement to encourage exploring all directions and 
  of course for hitting supermines/rocks!
 */
-double CQLearningController::R(uint x,uint y, uint sweeper_no){
+template <class Value>
+double CQLearningControllerT<Value>::R(uint x,uint y, uint sweeper_no){
 	
-	bool checkObj = false;
+	//Look up the first object placed at the position of the sweeper in the occupancy index..
+	int object = FirstObjectInCell(CellIndex(x, y));
 
-	//Loop through all the objects to see if one is at the position of the sweeper..
-	for (int i = 0; i < m_vecObjects.size(); ++i)
+	//if no object is found in the position of the sweeper
+	if (object == -1)
 	{
-		// get the x, y coordinates of the object on the grid
-		int xPos = m_vecObjects[i]->getPosition().x / CParams::iGridCellDim;
-		int yPos = m_vecObjects[i]->getPosition().y / CParams::iGridCellDim;
+		return emptyBlockReward;
+	}
 
-		//If the corrdinates of the object is the same as the sweeper...
-		if (xPos == x && yPos == y)
-		{
-			//MINE
-			if (m_vecObjects[i]->getType() == CCollisionObject::Mine)
-			{
-				clearState(x, y, sweeper_no);
-				return mineReward;
-			}
-			//ROCK
-			else if (m_vecObjects[i]->getType() == CCollisionObject::Rock)
-			{
-				return rockReward;
-			}
-			//SUPER MINE
-			else if (m_vecObjects[i]->getType() == CCollisionObject::SuperMine)
-			{
-				clearState(x, y, sweeper_no);
-				return supermineReward;
-			}
+	switch (m_vecObjects[object].getType())
+	{
+	//MINE
+	case CCollisionObject::Mine:
+		clearState(x, y, sweeper_no);
+		return mineReward;
+	//ROCK
+	case CCollisionObject::Rock:
+		return rockReward;
+	//SUPER MINE
+	case CCollisionObject::SuperMine:
+		clearState(x, y, sweeper_no);
+		return supermineReward;
+	}
 
-			checkObj = true; // object at position of sweeper
-		}
+	return 0;
+}
+
+/**
+The reward of the step a sweeper has just taken, for encoded states: what the parent's update made it
+collide with on its new cell. Unlike R() this does not depend on the position, so it means the same
+thing wherever the view around the sweeper is seen.
+*/
+template <class Value>
+double CQLearningControllerT<Value>::transitionReward(uint sweeper_no, int newX, int newY)
+{
+	if (!m_vecSweepers.Alive(sweeper_no))
+	{
+		//rocks stay where they are, supermines go with the sweeper
+		int object = CheckForObject(CellIndex(newX, newY));
+
+		return (object != -1 && m_vecObjects[object].getType() == CCollisionObject::Rock) ? rockReward : supermineReward;
 	}
 
-	//if no object is found in the position of the sweeper
-	if (!checkObj)
+	if (m_vecSweepers.MinesGathered(sweeper_no) > sweepersVector[sweeper_no].minesGathered)
 	{
-		return emptyBlockReward;
+		return mineReward;
 	}
 
-	return 0;
+	return emptyBlockReward;
 }
 
 /**
 This method is used to clear the state value of a specific block in the q table if a mine/supermine is found on the block.
 Mine/supermine won't be at this position in the future - so stop from moving here
 */
-void CQLearningController::clearState(uint x, uint y, uint sweeper_no)
+template <class Value>
+void CQLearningControllerT<Value>::clearState(uint x, uint y, uint sweeper_no)
 {
-	sweepersVector[sweeper_no].qTable[x][y].stateAction[0].stateValue = 0;
-	sweepersVector[sweeper_no].qTable[x][y].stateAction[1].stateValue = 0;
-	sweepersVector[sweeper_no].qTable[x][y].stateAction[2].stateValue = 0;
-	sweepersVector[sweeper_no].qTable[x][y].stateAction[3].stateValue = 0;
+	//an encoded state is not tied to one block - once the mine is gone the view around it changes anyway
+	if (stateEncoding != PositionState) return;
+
+	qTable.ClearCell(tableOf(sweeper_no), qTable.CellIndex(x, y));
 }
 
 /**
 The update method. Main loop body of our Q Learning implementation
 See: Watkins, Christopher JCH, and Peter Dayan. "Q-learning." Machine learning 8. 3-4 (1992): 279-292
 */
-bool CQLearningController::Update(void)
+template <class Value>
+bool CQLearningControllerT<Value>::Update(void)
 {
+	double tickStart = HighResTime();
+
 	//m_vecSweepers is the array of minesweepers
 	//everything you need will be m_[something] ;)
-	uint cDead = std::count_if(m_vecSweepers.begin(),
-							   m_vecSweepers.end(),
-						       [](CDiscMinesweeper * s)->bool{
-								return s->isDead();
-							   });
+	uint cDead = (uint)(m_vecSweepers.size() - m_vecSweepers.Active().size());
 
 	if (cDead == CParams::iNumSweepers){
 		printf("All dead ... skipping to next iteration\n");
 		m_iTicks = CParams::iNumTicks;
 	}
 
+	//evaluation: the parent steps every sweeper from the frozen policy and nothing is learnt
+	if (evaluating)
+	{
+		return CDiscController::Update();
+	}
+
 	//Lower epsilon over time to reduce sweeper exploration
 	if (m_iIterations%1000==0 && epsilon > 0.0)
 	{
@@ -160,10 +247,17 @@ bool CQLearningController::Update(void)
 	}
 	///////////////////////////////
 
+	double lookupStart = HighResTime();
+
+	//the states looked up from here to the end of the tick stay put
+	if (stateEncoding != PositionState) stateIndex.BeginTick();
+
 	//For each sweeper...
+	liveSweepers.clear();
 	for (uint sw = 0; sw < CParams::iNumSweepers; ++sw)
 	{
-		if (m_vecSweepers[sw]->isDead()) continue;
+		sweepersVector[sw].stepped = false;
+		if (!m_vecSweepers.Alive(sw)) continue;
 		/**
 		Q-learning algorithm according to:
 		Watkins, Christopher JCH, and Peter Dayan. "Q-learning." Machine learning 8. 3-4 (1992): 279-292
@@ -174,126 +268,434 @@ bool CQLearningController::Update(void)
 		/////////////////////////////////
 
 		//Getting the current sweeper position on the grid
-		int xPos = m_vecSweepers[sw]->Position().x / CParams::iGridCellDim;
-		int yPos = m_vecSweepers[sw]->Position().y / CParams::iGridCellDim;
+		int xPos = m_vecSweepers.X(sw) / CParams::iGridCellDim;
+		int yPos = m_vecSweepers.Y(sw) / CParams::iGridCellDim;
 
-		sweepersVector[sw].currentState = &sweepersVector[sw].qTable[xPos][yPos];
-		sweepersVector[sw].currentState->xPos = xPos;
-		sweepersVector[sw].currentState->yPos = yPos;
+		sweepersVector[sw].currentState = encodeState(sw, xPos, yPos);
+		sweepersVector[sw].xPos = xPos;
+		sweepersVector[sw].yPos = yPos;
+		sweepersVector[sw].minesGathered = m_vecSweepers.MinesGathered(sw);
+		sweepersVector[sw].stepped = true;
 
+		liveSweepers.push_back(sw);
+	}
 
-		////////////////////////////////////////////////////
-		//2:::Select action with highest historic return://
-		//////////////////////////////////////////////////
+	if (stateEncoding != PositionState)
+	{
+		lookupTime += HighResTime() - lookupStart;
+		lookupCount += liveSweepers.size();
+	}
+
+	////////////////////////////////////////////////////
+	//2:::Select action with highest historic return://
+	//////////////////////////////////////////////////
+
+	//Gather the Q values of every live sweeper's state and pick all the actions in one batch
+	uint numLive = liveSweepers.size();
+	if (numLive > 0)
+	{
+		batchValues.resize(numLive * NUM_ACTIONS);
+		batchExplore.resize(numLive);
+		batchBits.resize(numLive);
+		batchActions.resize(numLive);
+
+		for (uint i = 0; i < numLive; ++i)
+		{
+			uint sw = liveSweepers[i];
+			qTable.Load(tableOf(sw), sweepersVector[sw].currentState, &batchValues[i * NUM_ACTIONS]);
+		}
 
-		//Get the next action for the sweeper based on the highest historical return
-		sweepersVector[sw].nextAction = highestHistoricReturn(sweepersVector[sw].currentState, false); 
-		//Make the sweeper execute that action
-		m_vecSweepers[sw]->setRotation((ROTATION_DIRECTION)sweepersVector[sw].nextAction);
+		policyRng.FillFloat(&batchExplore[0], numLive);
+		policyRng.FillUint(&batchBits[0], numLive);
 
-		//now call the parents update, so all the sweepers fulfill their chosen action
+		SelectActions(&batchValues[0], &batchExplore[0], &batchBits[0], (float)epsilon, &batchActions[0], numLive);
+
+		for (uint i = 0; i < numLive; ++i)
+		{
+			uint sw = liveSweepers[i];
+			sweepersVector[sw].nextAction = batchActions[i];
+			sweepersVector[sw].greedyAction = batchValues[i * NUM_ACTIONS + batchActions[i]] == MaxValue(&batchValues[i * NUM_ACTIONS]);
+
+			//Watkins Q(lambda): an exploratory action cuts the traces, the return that follows
+			//is not the greedy policy's
+			if (!sweepersVector[sw].greedyAction) sweepersVector[sw].traces.clear();
+			//Make the sweeper execute that action
+			m_vecSweepers.SetRotation(sw, (ROTATION_DIRECTION)sweepersVector[sw].nextAction);
+		}
 	}
+
+	//now call the parents update, so all the sweepers fulfill their chosen action
 	
 	CDiscController::Update(); //call the parent's class update. Do not delete this.
 	
 	for (uint sw = 0; sw < CParams::iNumSweepers; ++sw)
 	{
-		if (m_vecSweepers[sw]->isDead()) continue;
+		//a sweeper that has just died learns nothing from the position encoding, while an
+		//encoded state learns from every step taken - including a fatal one
+		if (stateEncoding == PositionState ? !m_vecSweepers.Alive(sw) : !sweepersVector[sw].stepped) continue;
 		//TODO:compute your indexes.. it may also be necessary to keep track of the previous state
 		
 		///////////////////////////
 		//3:::Observe new state://
 		/////////////////////////
 
-		int xPos = sweepersVector[sw].currentState->xPos;
-		int yPos = sweepersVector[sw].currentState->yPos;
+		int xPos = sweepersVector[sw].xPos;
+		int yPos = sweepersVector[sw].yPos;
 
-		int newX = m_vecSweepers[sw]->Position().x / CParams::iGridCellDim;
-		int newY = m_vecSweepers[sw]->Position().y / CParams::iGridCellDim;
+		int newX = m_vecSweepers.X(sw) / CParams::iGridCellDim;
+		int newY = m_vecSweepers.Y(sw) / CParams::iGridCellDim;
 		
 		///////////////////////////////////
 		//4:::Update _Q_s_a accordingly://
 		/////////////////////////////////
 
-		State * nextState = &sweepersVector[sw].qTable[newX][newY]; //get the new state of the sweeper from its qTable
-		int currentStateAction = sweepersVector[sw].currentState->stateAction[sweepersVector[sw].nextAction].stateValue; //Q(s, a)  <-------------***!!!***
-		int bestAction = nextState->stateAction[highestHistoricReturn(nextState, true)].stateValue; //get the best action to perform based on sweepers next state
+		uint table = tableOf(sw);
+		uint currentState = sweepersVector[sw].currentState;
+		uint nextState = encodeState(sw, newX, newY); //get the new state of the sweeper from its qTable
+		double nextStateValues[NUM_ACTIONS];
+		qTable.Load(table, nextState, nextStateValues);
+		double currentStateAction = qTable.Get(table, currentState, sweepersVector[sw].nextAction); //Q(s, a)  <-------------***!!!***
+		double bestAction = MaxValue(nextStateValues); //get the value of the best action to perform in the sweepers next state
 
 		///////////////////////////////////////////////////////////////////////////////////
 		//Q(s,a) = Q(s,a) + (learning rate * (Reward + discount * (Q(s',a')) - Q(s,a))) //
 		/////////////////////////////////////////////////////////////////////////////////
 
-		//get the reward based on the sweepers postion
-		int reward = R(xPos, yPos, sw);
+		//get the reward based on the sweepers postion (or, for encoded states, on what the step ran into)
+		int reward = stateEncoding == PositionState ? R(xPos, yPos, sw) : transitionReward(sw, newX, newY);
 
-		if (reward == mineReward || reward == rockReward || reward == supermineReward)
+		//in shared mode another sweeper may have written Q(s,a) since it was read - like Hogwild
+		//the update is applied without a lock and the occasional lost update is accepted
+		double delta = reward + (discountFactor * bestAction) - currentStateAction;
+		double newValue;
+
+		if (lambda > 0)
 		{
-			sweepersVector[sw].currentState->stateAction[0].stateValue = currentStateAction + (learningRate * (reward + (discountFactor * bestAction) - currentStateAction));
-			sweepersVector[sw].currentState->stateAction[1].stateValue = currentStateAction + (learningRate * (reward + (discountFactor * bestAction) - currentStateAction));
-			sweepersVector[sw].currentState->stateAction[2].stateValue = currentStateAction + (learningRate * (reward + (discountFactor * bestAction) - currentStateAction));
-			sweepersVector[sw].currentState->stateAction[3].stateValue = currentStateAction + (learningRate * (reward + (discountFactor * bestAction) - currentStateAction));
+			newValue = updateTraces(sw, table, currentState, sweepersVector[sw].nextAction, currentStateAction, delta);
+		}
+		else
+		{
+			newValue = currentStateAction + (learningRate * delta);
+		}
+
+		if (stateEncoding == PositionState &&
+			(reward == mineReward || reward == rockReward || reward == supermineReward))
+		{
+			for (uint a = 0; a < NUM_ACTIONS; ++a)
+			{
+				qTable.Set(table, currentState, a, newValue);
+			}
 		}
 		else
 		{
-			sweepersVector[sw].currentState->stateAction[sweepersVector[sw].nextAction].stateValue = currentStateAction + (learningRate * (reward + (discountFactor * bestAction) - currentStateAction));
+			qTable.Set(table, currentState, sweepersVector[sw].nextAction, newValue);
+		}
+
+		//teach the planner's model
+		if (planner.Running())
+		{
+			planner.Observe(table, currentState, sweepersVector[sw].nextAction, (float)reward, nextState);
+		}
+
+		//keep the transition for replay
+		if (replay.Capacity() > 0)
+		{
+			replay.Push(table, currentState, sweepersVector[sw].nextAction, (float)reward, nextState,
+						generationOf(currentState), generationOf(nextState));
+			replayCredit += replayRatio;
 		}
 
 		// Set the current state to the maximum next state
 		sweepersVector[sw].currentState = nextState;
 	}
+
+	if (planner.Running()) planner.EndTick();
+
+	//more learning per simulated tick: replay whole batches of stored transitions
+	if (replay.Capacity() > 0 && replayBatchSize > 0)
+	{
+		while (replayCredit >= replayBatchSize && replay.Size() >= replayBatchSize)
+		{
+			replayBatch();
+			replayCredit -= replayBatchSize;
+		}
+	}
+
+	updateTime += HighResTime() - tickStart;
+	++updateTicks;
+
+	//the parent's update just rolled over to a new iteration - report the cost of the last one
+	if (m_iTicks == 0)
+	{
+		if (CParams::iCheckpointInterval > 0 && m_iIterations % CParams::iCheckpointInterval == 0)
+		{
+			SaveCheckpoint();
+		}
+
+		//the sweepers start the new iteration from scratch, so do their traces
+		for (uint sw = 0; sw < sweepersVector.size(); ++sw)
+		{
+			sweepersVector[sw].traces.clear();
+		}
+
+		if (CParams::bProfileUpdate)
+		{
+			std::cout << "Q-learning Update(): " << (updateTime / updateTicks) * 1e6 << " us per tick ("
+					  << CParams::iNumSweepers << " sweepers, " << m_vecObjects.size() << " objects)" << std::endl;
+		}
+		updateTime = 0;
+		updateTicks = 0;
+
+		if (stateEncoding != PositionState)
+		{
+			std::cout << "State index: " << stateIndex.UsedCells() << "/" << stateIndex.MaxCells() << " states ("
+					  << 100.0 * stateIndex.UsedCells() / stateIndex.NumSlots() << "% of slots), mean probe "
+					  << stateIndex.MeanProbe() << ", max probe " << stateIndex.MaxProbe() << ", "
+					  << stateIndex.Evictions() << " evictions, "
+					  << (lookupTime > 0 ? lookupCount / lookupTime : 0) << " lookups/s" << std::endl;
+			lookupTime = 0;
+			lookupCount = 0;
+		}
+
+		if (planner.Running())
+		{
+			uint64_t backups = planner.Backups();
+			std::cout << "Planner backups last iteration: " << backups - plannerBackupsReported << std::endl;
+			plannerBackupsReported = backups;
+		}
+
+		//report how long it took to first reach the target average of mines gathered
+		if (CParams::dTargetMines > 0 && !targetReached && m_vecAvMinesGathered.back() >= CParams::dTargetMines)
+		{
+			targetReached = true;
+			std::cout << "Reached target of " << CParams::dTargetMines << " average mines after " << m_iIterations
+					  << " iterations (" << HighResTime() - startTime << " s)" << std::endl;
+		}
+	}
 	return true;
 }
 
 /**
-Reutnr the index of the actions with the highest QValue
+Maps a sweeper standing on (x, y) onto its table cell. For the local view encoding the key is the 3x3
+block of object types around it (18 bits) and its heading, looked up in the state index. A state seen
+for the first time may get the cell of an evicted one, whose values are zeroed in every table.
+*/
+template <class Value>
+uint CQLearningControllerT<Value>::encodeState(uint sweeper_no, int x, int y)
+{
+	if (stateEncoding == PositionState)
+	{
+		return qTable.CellIndex(x, y);
+	}
+
+	uint64_t key = LocalView(x, y) | ((uint64_t)m_vecSweepers.Rotation(sweeper_no) << 18);
+
+	bool fresh = false;
+	uint cell = stateIndex.Lookup(key, fresh);
+
+	if (fresh)
+	{
+		for (uint t = 0; t < qTable.NumTables(); ++t) qTable.ClearCell(t, cell);
+	}
+
+	return cell;
+}
+
+/**
+Watkins Q(lambda) backup for one sweeper. The pair it has just left gets a (replacing) trace of 1,
+then every pair on its trace list moves by learningRate * delta * eligibility. Afterwards the traces
+decay by discountFactor * lambda and the ones below traceThreshold are dropped, so the list - and
+the cost of this call - stays bounded no matter how large the table is. A trace whose cell has
+been handed to another state since is dropped without an update.
+See: Sutton, Richard S., and Andrew G. Barto. "Reinforcement learning: An introduction." (1998), 7.6
 */
-int CQLearningController::highestHistoricReturn(State * currentState, bool findMax)
+template <class Value>
+double CQLearningControllerT<Value>::updateTraces(uint sweeper_no, uint table, uint state, uint action, double value, double delta)
 {
-	srand(time(NULL));
-	double prob = ((double)rand() / (RAND_MAX)); // random probability --> number between 0-1
+	std::vector<Trace> &traces = sweepersVector[sweeper_no].traces;
+
+	uint32_t generation = generationOf(state);
 
-	//With probability in range of epsilon -> choose one action at random
-	if (prob <= epsilon && findMax == false)
+	//replacing traces: a revisited pair goes back to 1 instead of accumulating
+	uint current = traces.size();
+	for (uint t = 0; t < traces.size(); ++t)
 	{
-		srand(time(NULL));
-		int move = rand() % 4;
+		if (traces[t].state == state && traces[t].action == action && traces[t].generation == generation)
+		{
+			current = t;
+			break;
+		}
+	}
+
+	if (current == traces.size())
+	{
+		//full list - forget the oldest trace
+		if (traces.size() == MAX_TRACES)
+		{
+			traces.erase(traces.begin());
+			--current;
+		}
 
-		return move;
+		Trace trace = {state, action, 1.0, generation};
+		traces.push_back(trace);
 	}
 	else
 	{
-		//EXPLOITATION
+		traces[current].eligibility = 1.0;
+	}
 
-		//If all actions are the same --> choose next action at random
-		if (currentState->stateAction[0].stateValue == currentState->stateAction[1].stateValue &&
-			currentState->stateAction[1].stateValue == currentState->stateAction[2].stateValue &&
-			currentState->stateAction[2].stateValue == currentState->stateAction[3].stateValue)
-		{
-			srand(time(NULL));
-			int move = rand() % 4;
+	double newValue = value;
+	double decay = discountFactor * lambda;
+	uint kept = 0;
 
-			return move;
-		}
-		else
-		{
-			//Find the action with the highest return
-			int maxIndex = 0;
+	for (uint t = 0; t < traces.size(); ++t)
+	{
+		Trace trace = traces[t];
 
-			for (int i = 1; i < 4; ++i)
-			{
-				if (currentState->stateAction[i].stateValue > currentState->stateAction[maxIndex].stateValue)
-				{
-					maxIndex = i;
-				}
-			}
+		if (t != current && trace.generation != generationOf(trace.state)) continue;
+
+		double oldValue = (t == current) ? value : qTable.Get(table, trace.state, trace.action);
+		double updated = oldValue + (learningRate * delta * trace.eligibility);
 
-			return maxIndex;
+		qTable.Set(table, trace.state, trace.action, updated);
+		if (t == current) newValue = updated;
 
+		//decay and prune in the same pass
+		trace.eligibility *= decay;
+		if (trace.eligibility >= traceThreshold)
+		{
+			traces[kept++] = trace;
 		}
 	}
+
+	traces.resize(kept);
+
+	return newValue;
 }
 
-CQLearningController::~CQLearningController(void)
+/**
+Replays a batch of stored transitions. The batch comes back from the ring sorted by table and cell,
+so the updates walk the arena in address order. Each one is the plain one-step rule
+Q(s,a) += learningRate * (r + discount * max Q(s') - Q(s,a)) against the current table. Transitions
+whose cells have been handed to other states since they were stored are skipped.
+*/
+template <class Value>
+void CQLearningControllerT<Value>::replayBatch(void)
+{
+	const std::vector<uint64_t> &batch = replay.Sample(replayBatchSize, qTable.CellsPerTable(), replayRng);
+
+	for (uint i = 0; i < batch.size(); ++i)
+	{
+		uint slot = CReplayBuffer::Slot(batch[i]);
+		uint table = replay.Table(slot);
+		uint cell = replay.Cell(slot);
+		uint action = replay.Action(slot);
+
+		if (replay.CellGeneration(slot) != generationOf(cell) ||
+			replay.NextGeneration(slot) != generationOf(replay.NextCell(slot))) continue;
+
+		double nextStateValues[NUM_ACTIONS];
+		qTable.Load(table, replay.NextCell(slot), nextStateValues);
+
+		double value = qTable.Get(table, cell, action);
+		double delta = replay.Reward(slot) + (discountFactor * MaxValue(nextStateValues)) - value;
+
+		qTable.Set(table, cell, action, value + (learningRate * delta));
+	}
+}
+
+/**
+Saves the Q tables of all the sweepers to the checkpoint file
+*/
+template <class Value>
+bool CQLearningControllerT<Value>::SaveCheckpoint(void)
+{
+	if (stateEncoding != PositionState)
+	{
+		std::cout << "Checkpoints need the position state encoding" << std::endl;
+		return false;
+	}
+
+	if (checkpointRejected)
+	{
+		std::cout << "Not saving over the rejected checkpoint " << CParams::sCheckpointFilename << std::endl;
+		return false;
+	}
+
+	double saveStart = HighResTime();
+
+	if (!qTable.SaveCheckpoint(CParams::sCheckpointFilename.c_str()))
+	{
+		std::cout << "Could not save checkpoint " << CParams::sCheckpointFilename << std::endl;
+		return false;
+	}
+
+	std::cout << "Saved checkpoint " << CParams::sCheckpointFilename << " after " << m_iIterations
+			  << " iterations (" << (HighResTime() - saveStart) * 1e3 << " ms)" << std::endl;
+	return true;
+}
+
+/**
+Compiles the greedy policy of the Q tables into the packed policy map: one map per table, or a single
+map from the summed tables if bSharedPolicy is set. Ties are broken from their own policy stream so
+compiling does not disturb the exploration draws.
+*/
+template <class Value>
+void CQLearningControllerT<Value>::compilePolicy(void)
+{
+	double compileStart = HighResTime();
+
+	CRandomStream tieRng = CRandomService::Stream(CRandomService::Policy, 1);
+	policyMap.Compile(qTable, _grid_size_x, _grid_size_y, CParams::bSharedPolicy, tieRng);
+
+	std::cout << "Policy map: " << policyMap.NumMaps() << (policyMap.NumMaps() == 1 ? " map, " : " maps, ")
+			  << policyMap.Bytes() << " bytes (" << (HighResTime() - compileStart) * 1e3 << " ms)" << std::endl;
+}
+
+/**
+Switches between learning and evaluating. Entering evaluation compiles the tables as they are now, so
+the sweepers run the current greedy policy without exploring or learning; leaving it goes back to
+learning where it stopped.
+*/
+template <class Value>
+void CQLearningControllerT<Value>::EvaluationToggle(void)
+{
+	//the policy map is laid out over the grid
+	if (stateEncoding != PositionState)
+	{
+		std::cout << "Evaluation needs the position state encoding" << std::endl;
+		return;
+	}
+
+	evaluating = !evaluating;
+
+	//the steps taken in between are not part of any trace
+	for (uint sw = 0; sw < sweepersVector.size(); ++sw)
+	{
+		sweepersVector[sw].traces.clear();
+	}
+
+	if (evaluating)
+	{
+		compilePolicy();
+		SetPolicy(&policyMap);
+	}
+	else
+	{
+		SetPolicy(NULL);
+	}
+
+	std::cout << (evaluating ? "Evaluating the greedy policy" : "Learning") << std::endl;
+}
+
+template <class Value>
+CQLearningControllerT<Value>::~CQLearningControllerT(void)
 {
 	//TODO: dealloc stuff here if you need to	
 }
+
+//the value types the controller is built with
+template class CQLearningControllerT<int>;
+template class CQLearningControllerT<float>;
+template class CQLearningControllerT<double>;
+template class CQLearningControllerT<SFixed16>;
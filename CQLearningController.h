@@ -1,34 +1,37 @@
 #pragma once
-#include "cdisccontroller.h"
+#include "CDiscController.h"
 #include "CParams.h"
 #include "CDiscCollisionObject.h"
+#include "CQTable.h"
+#include "CRandom.h"
+#include "CActionSelector.h"
+#include "CReplayBuffer.h"
+#include "CPlanner.h"
+#include "CPolicyMap.h"
+#include "CStateIndex.h"
 #include <cmath>
 
 typedef unsigned int uint;
 
-struct Action
+//an active eligibility trace: a state-action pair the sweeper visited recently, and the
+//generation of the state's cell then (encoded states can lose their cell to another state)
+struct Trace
 {
-	//Constructor for Action
-	Action(ROTATION_DIRECTION a); //Rotation direction is enum in CDiscMineSweeper
-	
-	ROTATION_DIRECTION action;  //store action move to next state
-
-	// Value for state, action pair initialized to 0
-	int stateValue = 0;
-		
+	uint state;
+	uint action;
+	double eligibility;
+	uint32_t generation;
 };
 
-struct State
-{
-	//State contructor
-	State();
-
-	//Position of the state on the grid
-	int xPos;
-	int yPos;
+//hard limit on the active traces of a sweeper, on top of the pruning threshold
+const uint MAX_TRACES = 64;
 
-	// Vector of actions to be performed in the state
-	std::vector<Action> stateAction;
+//what a state is (CParams::iStateEncoding). Encodings other than the position are
+//hashed into a capped table through a CStateIndex
+enum StateEncoding
+{
+	PositionState,		//the grid cell the sweeper is on
+	LocalViewState		//the objects in the 3x3 block around the sweeper and its heading
 };
 
 struct Sweeper
@@ -37,19 +40,61 @@ struct Sweeper
 	Sweeper();
 
 	int nextAction = 0;
-	State * currentState = NULL;
-	//2D vector representing the qTable
-	std::vector<std::vector<State>> qTable;
+
+	//false if nextAction was an exploratory (non-greedy) choice
+	bool greedyAction = true;
+
+	//Position and arena index of the state the sweeper is currently in
+	int xPos = 0;
+	int yPos = 0;
+	uint currentState = 0;
+
+	//mines gathered when the current state was observed and whether the sweeper was alive then
+	double minesGathered = 0;
+	bool stepped = false;
+
+	//Q(lambda) traces, oldest first - only pairs above the threshold are kept
+	std::vector<Trace> traces;
 };
 
-class CQLearningController :
+//the Q-learning controller, templated on the type its Q values are stored
+//as (int, float, double or SFixed16 - see QValueTraits in CQTable.h)
+template <class Value>
+class CQLearningControllerT :
 	public CDiscController
 {
 private:
 	uint _grid_size_x;
 	uint _grid_size_y;
 
-	std::vector<Sweeper> sweepersVector; //vecotr of all the sweepers tables
+	std::vector<Sweeper> sweepersVector; //vecotr of all the sweepers
+
+	//the Q tables of all the sweepers, stored one after the other
+	CQTable<Value> qTable;
+
+	//true if all the sweepers learn in one shared table
+	bool sharedTable = false;
+
+	//index of the table a sweeper reads and writes
+	uint tableOf(uint sweeper_no) const { return sharedTable ? 0 : sweeper_no; }
+
+	//random stream for the exploration and tie-breaking draws
+	CRandomStream policyRng;
+
+	//staging buffers for the batch action selection (indexed by live sweeper)
+	std::vector<uint> liveSweepers;
+	std::vector<float> batchValues;
+	std::vector<float> batchExplore;
+	std::vector<uint32_t> batchBits;
+	std::vector<int> batchActions;
+
+	//time spent in Update() and number of ticks during the current iteration (profiling)
+	double updateTime = 0;
+	uint updateTicks = 0;
+
+	//wall clock time when learning started and whether dTargetMines has been reached yet
+	double startTime = 0;
+	bool targetReached = false;
 
 	//REWARDS//
 	int mineReward = 100;
@@ -62,14 +107,68 @@ private:
 	double discountFactor = 0.6;
 	double epsilon = 0.5;
 
+	//Q(lambda): trace decay (0 = one-step Q-learning) and the eligibility below which a trace is dropped
+	double lambda = 0;
+	double traceThreshold = 0.01;
+
+	//experience replay: recent transitions, the stream the batches are drawn from, the size of a
+	//batch, replayed transitions per new one and the replays owed but not yet run
+	CReplayBuffer replay;
+	CRandomStream replayRng;
+	uint replayBatchSize = 0;
+	double replayRatio = 0;
+	double replayCredit = 0;
+
+	//replays one batch of stored transitions, in arena order, with the one-step rule
+	void replayBatch(void);
+
+	//optional background prioritized-sweeping planner (declared after qTable, so it stops first)
+	CPlanner<Value> planner;
+	uint64_t plannerBackupsReported = 0;
+
+	//inference only: the greedy policy compiled from qTable and whether the sweepers follow it
+	CPolicyMap policyMap;
+	bool evaluating = false;
+
+	//compiles qTable into policyMap
+	void compilePolicy(void);
+
+	//true if the warm start found a checkpoint that does not fit the tables, which is then never
+	//overwritten
+	bool checkpointRejected = false;
+
+	//the state encoding and, unless it is the position, the index from encoded states to table cells
+	StateEncoding stateEncoding = PositionState;
+	CStateIndex stateIndex;
+
+	//time spent and lookups made encoding the current states this iteration
+	double lookupTime = 0;
+	uint64_t lookupCount = 0;
+
+	//returns the table cell of the state a sweeper standing on (x, y) is in
+	uint encodeState(uint sweeper_no, int x, int y);
+
+	//generation of a table cell: how many times it has been handed to another state
+	uint32_t generationOf(uint cell) const { return stateEncoding == PositionState ? 0 : stateIndex.Generation(cell); }
+
+	//applies the TD error of a sweeper's last step along its trace list and
+	//returns the new value of the pair it has just left
+	double updateTraces(uint sweeper_no, uint table, uint state, uint action, double value, double delta);
+
 
 public:
-	CQLearningController(HWND hwndMain);
+	CQLearningControllerT(HWND hwndMain);
 	virtual void InitializeLearningAlgorithm(void);
 	double R(uint x, uint y, uint sweeper_no);
+	double transitionReward(uint sweeper_no, int newX, int newY);
 	void clearState(uint x, uint y, uint sweeper_no);
 	virtual bool Update(void);
-	int highestHistoricReturn(State * currentState, bool findMax);
-	virtual ~CQLearningController(void);
+	virtual bool SaveCheckpoint(void);
+	virtual void EvaluationToggle(void);
+	virtual ~CQLearningControllerT(void);
 };
 
+//the controller the GUI, trainer and sweep runner use. float values keep the small TD updates
+//the original int table truncated away; CQLearningControllerT<int> reproduces the old runs
+typedef CQLearningControllerT<float> CQLearningController;
+
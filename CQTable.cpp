@@ -0,0 +1,448 @@
+#include "CQTable.h"
+#include "CMappedFile.h"
+#include "CRandom.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+
+//spreads the three low bits of a coordinate apart so that an x and a y
+//value can be interleaved into a Morton code
+static const uint MortonSpread[CQTableShape::TILE_DIM] = {0, 1, 4, 5, 16, 17, 20, 21};
+
+CQTableShape::CQTableShape(): m_iNumTables(0),
+							  m_iGridX(0),
+							  m_iGridY(0),
+							  m_Layout(RowMajor),
+							  m_iTilesX(0),
+							  m_iCellsPerTable(0)
+{
+}
+
+size_t CQTableShape::SetShape(uint numTables, uint gridX, uint gridY, Layout layout)
+{
+	m_iNumTables = numTables;
+	m_iGridX = gridX;
+	m_iGridY = gridY;
+	m_Layout = layout;
+
+	m_iTilesX = m_Layout == ZOrderTiled ? (gridX + TILE_DIM - 1) / TILE_DIM : 0;
+	m_iCellsPerTable = CellCount(layout, gridX, gridY);
+
+	return (size_t)m_iNumTables * m_iCellsPerTable * NUM_ACTIONS;
+}
+
+uint CQTableShape::CellCount(Layout layout, uint gridX, uint gridY)
+{
+	if (layout == ZOrderTiled)
+	{
+		//pad the grid up to a whole number of tiles
+		uint tilesX = (gridX + TILE_DIM - 1) / TILE_DIM;
+		uint tilesY = (gridY + TILE_DIM - 1) / TILE_DIM;
+		return tilesX * tilesY * TILE_DIM * TILE_DIM;
+	}
+
+	return gridX * gridY;
+}
+
+//-------------------------------CellIndex()-------------------------------
+//
+//	row major: x * gridY + y (matches the old qTable[x][y] ordering)
+//	Z-order:   tile index * 64 + Morton code of the position in the tile
+//
+//-------------------------------------------------------------------------
+uint CQTableShape::CellIndex(Layout layout, uint tilesX, uint gridY, uint x, uint y)
+{
+	if (layout == ZOrderTiled)
+	{
+		uint tile = (y / TILE_DIM) * tilesX + (x / TILE_DIM);
+		uint morton = MortonSpread[x % TILE_DIM] | (MortonSpread[y % TILE_DIM] << 1);
+		return tile * TILE_DIM * TILE_DIM + morton;
+	}
+
+	return x * gridY + y;
+}
+
+bool CQTableShape::Matches(const SQTableCheckpointHeader &header, ValueType type) const
+{
+	return memcmp(header.magic, "QTBL", 4) == 0 &&
+		   header.version == QTABLE_CHECKPOINT_VERSION &&
+		   header.numTables == m_iNumTables &&
+		   header.gridX == m_iGridX &&
+		   header.gridY == m_iGridY &&
+		   header.numActions == NUM_ACTIONS &&
+		   header.valueType == (uint32_t)type &&
+		   header.layout <= (uint32_t)ZOrderTiled &&
+		   header.cellsPerTable == CellCount((Layout)header.layout, m_iGridX, m_iGridY);
+}
+
+//-------------------------------Allocate()--------------------------------
+//
+//	allocates all the tables in one shot - table t starts at offset
+//	t * CellsPerTable() * NUM_ACTIONS
+//
+//-------------------------------------------------------------------------
+template <class Value>
+void CQTable<Value>::Allocate(uint numTables, uint gridX, uint gridY, Layout layout)
+{
+	size_t count = SetShape(numTables, gridX, gridY, layout);
+
+	//atomics cannot be copied, so build a fresh vector and swap it in
+	std::vector<std::atomic<Storage> >(count).swap(m_vecValues);
+
+	for (size_t i = 0; i < m_vecValues.size(); ++i)
+	{
+		m_vecValues[i].store(Traits::FromDouble(0), std::memory_order_relaxed);
+	}
+}
+
+template <class Value>
+void CQTable<Value>::Load(uint table, uint cell, float * values) const
+{
+	size_t offset = Offset(table, cell);
+
+	for (uint a = 0; a < NUM_ACTIONS; ++a)
+	{
+		values[a] = (float)Traits::ToDouble(m_vecValues[offset + a].load(std::memory_order_relaxed));
+	}
+}
+
+template <class Value>
+void CQTable<Value>::Load(uint table, uint cell, double * values) const
+{
+	size_t offset = Offset(table, cell);
+
+	for (uint a = 0; a < NUM_ACTIONS; ++a)
+	{
+		values[a] = Traits::ToDouble(m_vecValues[offset + a].load(std::memory_order_relaxed));
+	}
+}
+
+template <class Value>
+void CQTable<Value>::ClearCell(uint table, uint cell)
+{
+	size_t offset = Offset(table, cell);
+
+	for (uint a = 0; a < NUM_ACTIONS; ++a)
+	{
+		m_vecValues[offset + a].store(Traits::FromDouble(0), std::memory_order_relaxed);
+	}
+}
+
+//----------------------------SaveCheckpoint()-----------------------------
+//
+//	header followed by the raw arena, written in chunks so the atomics can
+//	be read with relaxed loads
+//
+//-------------------------------------------------------------------------
+template <class Value>
+bool CQTable<Value>::SaveCheckpoint(const char* szFileName) const
+{
+	SQTableCheckpointHeader header;
+	memset(&header, 0, sizeof(header));
+
+	memcpy(header.magic, "QTBL", 4);
+	header.version = QTABLE_CHECKPOINT_VERSION;
+	header.numTables = m_iNumTables;
+	header.gridX = m_iGridX;
+	header.gridY = m_iGridY;
+	header.numActions = NUM_ACTIONS;
+	header.valueType = Traits::Type;
+	header.layout = m_Layout;
+	header.cellsPerTable = m_iCellsPerTable;
+
+	std::string tempName = std::string(szFileName) + ".tmp";
+
+	FILE* file = fopen(tempName.c_str(), "wb");
+
+	if (!file) return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	const size_t CHUNK = 4096;
+	Storage buffer[CHUNK];
+
+	for (size_t i = 0; ok && i < m_vecValues.size(); i += CHUNK)
+	{
+		size_t count = m_vecValues.size() - i < CHUNK ? m_vecValues.size() - i : CHUNK;
+
+		for (size_t k = 0; k < count; ++k)
+		{
+			buffer[k] = m_vecValues[i + k].load(std::memory_order_relaxed);
+		}
+
+		ok = fwrite(buffer, sizeof(Storage), count, file) == count;
+	}
+
+	ok = (fclose(file) == 0) && ok;
+
+	//replace the old checkpoint only once the new one is complete
+	if (ok)
+	{
+		remove(szFileName);
+		ok = rename(tempName.c_str(), szFileName) == 0;
+	}
+
+	if (!ok) remove(tempName.c_str());
+
+	return ok;
+}
+
+//----------------------------LoadCheckpoint()-----------------------------
+//
+//	the table must already be allocated with the shape to load into
+//
+//-------------------------------------------------------------------------
+template <class Value>
+bool CQTable<Value>::LoadCheckpoint(const char* szFileName)
+{
+	CMappedFile file;
+
+	if (!file.Open(szFileName) || file.Size() < sizeof(SQTableCheckpointHeader)) return false;
+
+	SQTableCheckpointHeader header;
+	memcpy(&header, file.Data(), sizeof(header));
+
+	if (!Matches(header, Traits::Type)) return false;
+
+	size_t count = (size_t)header.numTables * header.cellsPerTable * NUM_ACTIONS;
+
+	if (file.Size() < sizeof(header) + count * sizeof(Storage)) return false;
+
+	const char* values = file.Data() + sizeof(header);
+
+	if (header.layout == (uint32_t)m_Layout && header.cellsPerTable == m_iCellsPerTable)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			Storage value;
+			memcpy(&value, values + i * sizeof(Storage), sizeof(value));
+			m_vecValues[i].store(value, std::memory_order_relaxed);
+		}
+
+		return true;
+	}
+
+	//saved in the other layout - move every cell to where this layout keeps it
+	Layout savedLayout = (Layout)header.layout;
+	uint savedTilesX = (m_iGridX + TILE_DIM - 1) / TILE_DIM;
+
+	for (uint table = 0; table < m_iNumTables; ++table)
+	{
+		for (uint x = 0; x < m_iGridX; ++x)
+		{
+			for (uint y = 0; y < m_iGridY; ++y)
+			{
+				uint savedCell = CQTableShape::CellIndex(savedLayout, savedTilesX, m_iGridY, x, y);
+				size_t from = ((size_t)table * header.cellsPerTable + savedCell) * NUM_ACTIONS;
+				size_t to = Offset(table, CellIndex(x, y));
+
+				for (uint a = 0; a < NUM_ACTIONS; ++a)
+				{
+					Storage value;
+					memcpy(&value, values + (from + a) * sizeof(Storage), sizeof(value));
+					m_vecValues[to + a].store(value, std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+//the value types the controller is built with
+template class CQTable<int>;
+template class CQTable<float>;
+template class CQTable<double>;
+template class CQTable<SFixed16>;
+
+//------------------------------------------------------------------------
+//	the tables as they were before the arena: per sweeper, a vector of
+//	columns of States, each State owning a heap vector of its Actions
+//------------------------------------------------------------------------
+struct SNestedAction
+{
+	int		action;
+	int		stateValue;
+};
+
+struct SNestedState
+{
+	int		xPos;
+	int		yPos;
+	std::vector<SNestedAction>	stateAction;
+};
+
+typedef std::vector<std::vector<SNestedState> >	NestedTable;
+
+class CNestedTables
+{
+private:
+	std::vector<NestedTable>	m_vecTables;
+
+public:
+	CNestedTables(uint numTables, uint gridX, uint gridY)
+	{
+		m_vecTables.resize(numTables);
+
+		for (uint t = 0; t < numTables; ++t)
+		{
+			for (uint x = 0; x < gridX; ++x)
+			{
+				std::vector<SNestedState> column;
+
+				for (uint y = 0; y < gridY; ++y)
+				{
+					SNestedState state;
+					state.xPos = x;
+					state.yPos = y;
+
+					for (uint a = 0; a < NUM_ACTIONS; ++a)
+					{
+						SNestedAction action = {(int)a, 0};
+						state.stateAction.push_back(action);
+					}
+
+					column.push_back(state);
+				}
+
+				m_vecTables[t].push_back(column);
+			}
+		}
+	}
+
+	int		Get(uint table, uint x, uint y, uint action)const{return m_vecTables[table][x][y].stateAction[action].stateValue;}
+	void	Set(uint table, uint x, uint y, uint action, int value){m_vecTables[table][x][y].stateAction[action].stateValue = value;}
+};
+
+class CArenaTables
+{
+private:
+	CQTable<int>	m_Table;
+
+public:
+	CArenaTables(uint numTables, uint gridX, uint gridY, CQTableShape::Layout layout)
+	{
+		m_Table.Allocate(numTables, gridX, gridY, layout);
+	}
+
+	int		Get(uint table, uint x, uint y, uint action)const{return (int)m_Table.Get(table, m_Table.CellIndex(x, y), action);}
+	void	Set(uint table, uint x, uint y, uint action, int value){m_Table.Set(table, m_Table.CellIndex(x, y), action, value);}
+};
+
+//-----------------------------WalkTables----------------------------------
+//
+//	one-step Q-learning in the int arithmetic of the original controller.
+//	Every sweeper steps in the direction of its action (wrapping), backs up
+//	the pair it left and picks its next action greedily from the new cell,
+//	unless the pre-drawn exploration says otherwise. Returns the sum of the
+//	values the walk wrote, as a checksum
+//
+//-------------------------------------------------------------------------
+template <class Tables>
+static long WalkTables(Tables &tables, uint numTables, uint gridX, uint gridY, uint ticks,
+					   const std::vector<int> &rewards, const std::vector<int> &explore)
+{
+	static const int STEP_X[NUM_ACTIONS] = {-1, 1, 0, 0};
+	static const int STEP_Y[NUM_ACTIONS] = {0, 0, -1, 1};
+
+	std::vector<uint> x(numTables), y(numTables), action(numTables);
+
+	for (uint sw = 0; sw < numTables; ++sw)
+	{
+		x[sw] = (sw * 7) % gridX;
+		y[sw] = (sw * 13) % gridY;
+		action[sw] = sw % NUM_ACTIONS;
+	}
+
+	long checksum = 0;
+
+	for (uint tick = 0; tick < ticks; ++tick)
+	{
+		for (uint sw = 0; sw < numTables; ++sw)
+		{
+			uint a = action[sw];
+			uint newX = (x[sw] + gridX + STEP_X[a]) % gridX;
+			uint newY = (y[sw] + gridY + STEP_Y[a]) % gridY;
+
+			uint best = 0;
+			for (uint b = 1; b < NUM_ACTIONS; ++b)
+			{
+				if (tables.Get(sw, newX, newY, b) > tables.Get(sw, newX, newY, best)) best = b;
+			}
+
+			int q = tables.Get(sw, x[sw], y[sw], a);
+			int value = (int)(q + 0.75 * (rewards[newX * gridY + newY] + 0.6 * tables.Get(sw, newX, newY, best) - q));
+
+			tables.Set(sw, x[sw], y[sw], a, value);
+			checksum += value;
+
+			int draw = explore[((size_t)tick * numTables + sw) % explore.size()];
+
+			x[sw] = newX;
+			y[sw] = newY;
+			action[sw] = draw >= 0 ? (uint)draw : best;
+		}
+	}
+
+	return checksum;
+}
+
+//------------------------BenchmarkQTableLayouts---------------------------
+//
+//	a sparse grid of mine and supermine rewards, and one exploratory action
+//	in ten
+//
+//-------------------------------------------------------------------------
+void BenchmarkQTableLayouts(uint numTables, uint gridX, uint gridY, uint ticks)
+{
+	CRandomStream rng(12345);
+
+	std::vector<int> rewards(gridX * gridY, 0);
+	for (uint cell = 0; cell < rewards.size(); ++cell)
+	{
+		int draw = rng.RandInt(0, 19);
+
+		if (draw == 0) rewards[cell] = 100;
+		if (draw == 1) rewards[cell] = -100;
+	}
+
+	std::vector<int> explore(1 << 16);
+	for (uint i = 0; i < explore.size(); ++i)
+	{
+		explore[i] = rng.RandInt(0, 9) == 0 ? rng.RandInt(0, NUM_ACTIONS - 1) : -1;
+	}
+
+	double start = HighResTime();
+	CNestedTables nested(numTables, gridX, gridY);
+	double nestedSetup = HighResTime() - start;
+
+	start = HighResTime();
+	long nestedSum = WalkTables(nested, numTables, gridX, gridY, ticks, rewards, explore);
+	double nestedTime = HighResTime() - start;
+
+	start = HighResTime();
+	CArenaTables rowMajor(numTables, gridX, gridY, CQTableShape::RowMajor);
+	double rowMajorSetup = HighResTime() - start;
+
+	start = HighResTime();
+	long rowMajorSum = WalkTables(rowMajor, numTables, gridX, gridY, ticks, rewards, explore);
+	double rowMajorTime = HighResTime() - start;
+
+	start = HighResTime();
+	CArenaTables tiled(numTables, gridX, gridY, CQTableShape::ZOrderTiled);
+	double tiledSetup = HighResTime() - start;
+
+	start = HighResTime();
+	long tiledSum = WalkTables(tiled, numTables, gridX, gridY, ticks, rewards, explore);
+	double tiledTime = HighResTime() - start;
+
+	std::cout << "Q tables, " << numTables << " sweepers on " << gridX << "x" << gridY << " cells, "
+			  << ticks << " ticks (setup, then update cost per tick):" << std::endl;
+	std::cout << "  vector<vector<State>>: " << nestedSetup * 1e3 << " ms, " << nestedTime / ticks * 1e6 << " us" << std::endl;
+	std::cout << "  arena, row major:      " << rowMajorSetup * 1e3 << " ms, " << rowMajorTime / ticks * 1e6 << " us" << std::endl;
+	std::cout << "  arena, Z-order tiles:  " << tiledSetup * 1e3 << " ms, " << tiledTime / ticks * 1e6 << " us" << std::endl;
+	std::cout << "  layouts " << (nestedSum == rowMajorSum && nestedSum == tiledSum ? "agree" : "DISAGREE")
+			  << " (checksum " << nestedSum << ")" << std::endl;
+}
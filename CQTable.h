@@ -0,0 +1,233 @@
+#ifndef CQTABLE_H
+#define CQTABLE_H
+//------------------------------------------------------------------------
+//
+//	Name: CQTable.h
+//
+//  Desc: Contiguous arena holding the Q tables of every sweeper. All the
+//        values live in one allocation indexed [table][cell][action], so
+//        a state lookup is a multiply-add instead of a pointer chase.
+//
+//        Cells can be stored row major or in 8x8 tiles with a Z-order
+//        (Morton) curve inside each tile, so neighbouring cells share
+//        cache lines.
+//
+//        The stored value type is a template parameter (see QValueTraits):
+//        int, float, double or 16 bit fixed point, trading the memory and
+//        cache footprint of large grids against precision. Values go in
+//        and come out as doubles; the conversion is the only difference.
+//
+//        Every value is a relaxed atomic, so a single table can be shared
+//        by all the sweepers (Hogwild style) and read/written from several
+//        threads without locks. On x86 relaxed loads and stores compile to
+//        plain moves, so private tables pay nothing for this.
+//
+//        The whole arena can be saved to a versioned binary checkpoint and
+//        warm started from one (the file is memory mapped on load).
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+//one action per ROTATION_DIRECTION - the action index is the direction
+const uint NUM_ACTIONS = 4;
+
+//------------------------------------------------------------------------
+//	checkpoint file layout: this 64 byte header followed by the values of
+//	every table in arena order ([table][cell][action], in the recorded
+//	layout), in the native byte order
+//------------------------------------------------------------------------
+const uint32_t QTABLE_CHECKPOINT_VERSION = 1;
+
+struct SQTableCheckpointHeader
+{
+	char		magic[4];		//"QTBL"
+	uint32_t	version;
+	uint32_t	numTables;
+	uint32_t	gridX;
+	uint32_t	gridY;
+	uint32_t	numActions;
+	uint32_t	valueType;		//CQTableShape::ValueType of the stored values
+	uint32_t	layout;			//CQTableShape::Layout of the stored cells
+	uint32_t	cellsPerTable;
+	uint32_t	reserved[7];
+};
+
+//------------------------------------------------------------------------
+//	the part of the table that does not depend on the value type: the
+//	dimensions and the mapping from grid coordinates to cells
+//------------------------------------------------------------------------
+class CQTableShape
+{
+public:
+	enum Layout { RowMajor, ZOrderTiled };
+
+	//type of the stored values, recorded in checkpoints
+	enum ValueType { Int32, Float32, Float64, Fixed16 };
+
+	//side of the square tiles used by the Z-order layout
+	static const uint TILE_DIM = 8;
+
+protected:
+	uint				m_iNumTables;
+	uint				m_iGridX;
+	uint				m_iGridY;
+	Layout				m_Layout;
+
+	//number of tiles in a row of the Z-order layout
+	uint				m_iTilesX;
+
+	//number of cells per table (including tile padding)
+	uint				m_iCellsPerTable;
+
+	//sets the dimensions, returns the number of values the arena needs
+	size_t		SetShape(uint numTables, uint gridX, uint gridY, Layout layout);
+
+	//index of the first action value of a cell
+	size_t		Offset(uint table, uint cell) const
+	{
+		return ((size_t)table * m_iCellsPerTable + cell) * NUM_ACTIONS;
+	}
+
+	//cell index of (x, y) in any layout
+	static uint	CellIndex(Layout layout, uint tilesX, uint gridY, uint x, uint y);
+
+	//number of cells per table of a gridX x gridY grid in any layout
+	static uint	CellCount(Layout layout, uint gridX, uint gridY);
+
+	//returns true if a checkpoint header fits these dimensions and value type
+	bool		Matches(const SQTableCheckpointHeader &header, ValueType type) const;
+
+public:
+	CQTableShape();
+
+	//maps a grid coordinate onto its cell index in the current layout
+	uint		CellIndex(uint x, uint y) const
+	{
+		return CellIndex(m_Layout, m_iTilesX, m_iGridY, x, y);
+	}
+
+	//-------------------accessor functions
+	uint		NumTables()const{return m_iNumTables;}
+	uint		CellsPerTable()const{return m_iCellsPerTable;}
+	Layout		GetLayout()const{return m_Layout;}
+};
+
+//------------------------------------------------------------------------
+//	storage of the Q values. Each specialization gives the stored type,
+//	its checkpoint code and the conversions to and from double.
+//------------------------------------------------------------------------
+template <class Value> struct QValueTraits;
+
+template <> struct QValueTraits<int>
+{
+	typedef int32_t Storage;
+	static const CQTableShape::ValueType Type = CQTableShape::Int32;
+	static const char* Name(){return "int";}
+
+	//truncates toward zero like the original int table
+	static Storage	FromDouble(double value){return (Storage)value;}
+	static double	ToDouble(Storage value){return value;}
+};
+
+template <> struct QValueTraits<float>
+{
+	typedef float Storage;
+	static const CQTableShape::ValueType Type = CQTableShape::Float32;
+	static const char* Name(){return "float";}
+
+	static Storage	FromDouble(double value){return (Storage)value;}
+	static double	ToDouble(Storage value){return value;}
+};
+
+template <> struct QValueTraits<double>
+{
+	typedef double Storage;
+	static const CQTableShape::ValueType Type = CQTableShape::Float64;
+	static const char* Name(){return "double";}
+
+	static Storage	FromDouble(double value){return value;}
+	static double	ToDouble(Storage value){return value;}
+};
+
+//tag for the 16 bit fixed point table: steps of 1/32, range +-1023
+struct SFixed16 {};
+
+template <> struct QValueTraits<SFixed16>
+{
+	typedef int16_t Storage;
+	static const CQTableShape::ValueType Type = CQTableShape::Fixed16;
+	static const char* Name(){return "int16 fixed point";}
+
+	static const int SCALE = 32;
+
+	//rounds to the nearest step and saturates instead of wrapping
+	static Storage	FromDouble(double value)
+	{
+		double scaled = value * SCALE + (value < 0 ? -0.5 : 0.5);
+
+		if (scaled >= 32767.0) return 32767;
+		if (scaled <= -32768.0) return -32768;
+
+		return (Storage)scaled;
+	}
+	static double	ToDouble(Storage value){return value * (1.0 / SCALE);}
+};
+
+template <class Value>
+class CQTable : public CQTableShape
+{
+public:
+	typedef QValueTraits<Value>				Traits;
+	typedef typename Traits::Storage		Storage;
+
+private:
+	std::vector<std::atomic<Storage> >	m_vecValues;
+
+public:
+	//(re)allocates the arena and zeroes every value
+	void		Allocate(uint numTables, uint gridX, uint gridY, Layout layout);
+
+	//reads/writes a single state-action value
+	double		Get(uint table, uint cell, uint action) const
+	{
+		return Traits::ToDouble(m_vecValues[Offset(table, cell) + action].load(std::memory_order_relaxed));
+	}
+	void		Set(uint table, uint cell, uint action, double value)
+	{
+		m_vecValues[Offset(table, cell) + action].store(Traits::FromDouble(value), std::memory_order_relaxed);
+	}
+
+	//copies the NUM_ACTIONS values of a cell into values
+	void		Load(uint table, uint cell, float * values) const;
+	void		Load(uint table, uint cell, double * values) const;
+
+	//zeroes every action value of a cell
+	void		ClearCell(uint table, uint cell);
+
+	//writes every table to a checkpoint file (through a temporary file, so
+	//an interrupted save never destroys the previous checkpoint)
+	bool		SaveCheckpoint(const char* szFileName) const;
+
+	//maps a checkpoint and copies it into the arena. Fails, leaving the
+	//arena untouched, if the file is missing or was written for a different
+	//number of tables, grid, action count or value type. A checkpoint saved
+	//in the other layout is converted cell by cell.
+	bool		LoadCheckpoint(const char* szFileName);
+
+	//-------------------accessor functions
+	size_t		BytesPerState()const{return NUM_ACTIONS * sizeof(std::atomic<Storage>);}
+	size_t		Bytes()const{return m_vecValues.size() * sizeof(std::atomic<Storage>);}
+};
+
+//times Q-learning updates of numTables sweepers walking a gridX x gridY grid,
+//each in its own table, with the original per-sweeper vector<vector<State>>
+//tables and with the arena in both layouts. All three run the same walk, so
+//they must end with the same values
+void BenchmarkQTableLayouts(uint numTables, uint gridX, uint gridY, uint ticks);
+
+#endif
@@ -0,0 +1,69 @@
+#include "CRandom.h"
+
+uint64_t CRandomService::m_MasterSeed = 1;
+
+//------------------------------SplitMix64---------------------------------
+//
+//	mixes a 64 bit value - used to turn seeds and stream keys into well
+//	distributed generator states
+//
+//-------------------------------------------------------------------------
+static uint64_t SplitMix64(uint64_t &x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+CRandomStream::CRandomStream()
+{
+	Seed(0);
+}
+
+CRandomStream::CRandomStream(uint64_t seed)
+{
+	Seed(seed);
+}
+
+void CRandomStream::Seed(uint64_t seed)
+{
+	uint64_t a = SplitMix64(seed);
+	uint64_t b = SplitMix64(seed);
+
+	m_State[0] = (uint32_t)a;
+	m_State[1] = (uint32_t)(a >> 32);
+	m_State[2] = (uint32_t)b;
+	m_State[3] = (uint32_t)(b >> 32);
+
+	//the all zero state is the one state xoshiro can never leave
+	if (!(m_State[0] | m_State[1] | m_State[2] | m_State[3]))
+	{
+		m_State[0] = 1;
+	}
+}
+
+void CRandomStream::FillFloat(float * out, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		//24 bits fill a float mantissa exactly, so the result stays below 1
+		out[i] = (Next() >> 8) * (1.0f / 16777216.0f);
+	}
+}
+
+void CRandomStream::FillUint(uint32_t * out, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		out[i] = Next();
+	}
+}
+
+CRandomStream CRandomService::Stream(Domain domain, uint32_t index)
+{
+	uint64_t key = ((uint64_t)domain << 32) | index;
+	uint64_t mixedKey = SplitMix64(key);
+
+	return CRandomStream(m_MasterSeed ^ mixedKey);
+}
@@ -0,0 +1,92 @@
+#ifndef CRANDOM_H
+#define CRANDOM_H
+//------------------------------------------------------------------------
+//
+//	Name: CRandom.h
+//
+//  Desc: Random number service. Every environment, sweeper, policy and
+//        network draws from its own CRandomStream, so nothing shares the
+//        global rand() state and streams can be used from worker threads
+//        without contention.
+//
+//        Each stream is an xoshiro128** generator whose state is derived
+//        (SplitMix64) from the master seed and a (domain, index) key, so
+//        a whole run is bit reproducible from one seed and a stream never
+//        depends on how many numbers another stream has drawn.
+//
+//------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+
+class CRandomStream
+{
+private:
+	uint32_t	m_State[4];
+
+	static uint32_t Rotl(uint32_t x, int k){return (x << k) | (x >> (32 - k));}
+
+public:
+	CRandomStream();
+	explicit CRandomStream(uint64_t seed);
+
+	void		Seed(uint64_t seed);
+
+	//next raw 32 bit output
+	uint32_t	Next()
+	{
+		uint32_t result = Rotl(m_State[1] * 5, 7) * 9;
+		uint32_t t = m_State[1] << 9;
+
+		m_State[2] ^= m_State[0];
+		m_State[3] ^= m_State[1];
+		m_State[1] ^= m_State[2];
+		m_State[0] ^= m_State[3];
+		m_State[2] ^= t;
+		m_State[3] = Rotl(m_State[3], 11);
+
+		return result;
+	}
+
+	//returns a random integer between x and y (inclusive)
+	int			RandInt(int x, int y)
+	{
+		return x + (int)(((uint64_t)Next() * (uint32_t)(y - x + 1)) >> 32);
+	}
+
+	//returns a random float between zero and 1 (excluding 1)
+	double		RandFloat(){return Next() * (1.0 / 4294967296.0);}
+
+	//returns a random bool
+	bool		RandBool(){return (Next() >> 31) != 0;}
+
+	//returns a random float in the range -1 < n < 1
+	double		RandomClamped(){return RandFloat() - RandFloat();}
+
+	//bulk versions for vectorized consumers (e.g. epsilon draws for every sweeper)
+	void		FillFloat(float * out, size_t n);
+	void		FillUint(uint32_t * out, size_t n);
+
+	//the raw generator state, so a stream can be saved and picked up later
+	void		GetState(uint32_t state[4])const{for (int i = 0; i < 4; ++i) state[i] = m_State[i];}
+	void		SetState(const uint32_t state[4]){for (int i = 0; i < 4; ++i) m_State[i] = state[i];}
+};
+
+class CRandomService
+{
+public:
+	//the independent families of streams used by the simulation
+	enum Domain { Environment, Sweeper, Policy, Network, Replay, Scenario };
+
+private:
+	static uint64_t	m_MasterSeed;
+
+public:
+	//sets the seed every stream is derived from
+	static void		SetMasterSeed(uint64_t seed){m_MasterSeed = seed;}
+	static uint64_t	MasterSeed(){return m_MasterSeed;}
+
+	//returns the stream for (domain, index) - the same key always gives the same stream
+	static CRandomStream Stream(Domain domain, uint32_t index);
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "CReplayBuffer.h"
+#include <algorithm>
+
+CReplayBuffer::CReplayBuffer(): m_iCapacity(0),
+								m_iHead(0),
+								m_iSize(0)
+{
+}
+
+void CReplayBuffer::Allocate(uint capacity)
+{
+	m_iCapacity = capacity;
+	m_iHead = 0;
+	m_iSize = 0;
+
+	m_vecTable.assign(capacity, 0);
+	m_vecCell.assign(capacity, 0);
+	m_vecAction.assign(capacity, 0);
+	m_vecReward.assign(capacity, 0);
+	m_vecNextCell.assign(capacity, 0);
+	m_vecCellGeneration.assign(capacity, 0);
+	m_vecNextGeneration.assign(capacity, 0);
+}
+
+//---------------------------------Sample()--------------------------------
+//
+//	the slot rides in the low 32 bits of each key, so sorting the keys
+//	sorts the batch by arena position and keeps the slots with them
+//
+//-------------------------------------------------------------------------
+const std::vector<uint64_t>& CReplayBuffer::Sample(uint n, uint cellsPerTable, CRandomStream &rng)
+{
+	m_vecKeys.resize(m_iSize > 0 ? n : 0);
+
+	for (uint i = 0; i < m_vecKeys.size(); ++i)
+	{
+		uint slot = (uint)rng.RandInt(0, m_iSize - 1);
+		uint64_t position = (uint64_t)m_vecTable[slot] * cellsPerTable + m_vecCell[slot];
+
+		m_vecKeys[i] = (position << 32) | slot;
+	}
+
+	std::sort(m_vecKeys.begin(), m_vecKeys.end());
+
+	return m_vecKeys;
+}
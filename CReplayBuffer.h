@@ -0,0 +1,89 @@
+#ifndef CREPLAYBUFFER_H
+#define CREPLAYBUFFER_H
+//------------------------------------------------------------------------
+//
+//	Name: CReplayBuffer.h
+//
+//  Desc: Fixed capacity experience replay ring. Transitions (table, cell,
+//        action, reward, next cell) are stored as a struct of arrays so
+//        the batch update streams through each field separately, and the
+//        oldest transition is overwritten once the ring is full. Each one
+//        also keeps the generations its two cells had when it was pushed
+//        (see CStateIndex), so a transition whose cells have since been
+//        handed to other states can be skipped.
+//
+//        Sample() draws a batch and returns it sorted by arena position
+//        (table, then cell), so replaying it walks the Q table in address
+//        order instead of jumping around it.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <stdint.h>
+#include "CRandom.h"
+
+typedef unsigned int uint;
+
+class CReplayBuffer
+{
+private:
+	std::vector<uint>		m_vecTable;
+	std::vector<uint>		m_vecCell;
+	std::vector<uint8_t>	m_vecAction;
+	std::vector<float>		m_vecReward;
+	std::vector<uint>		m_vecNextCell;
+	std::vector<uint32_t>	m_vecCellGeneration;
+	std::vector<uint32_t>	m_vecNextGeneration;
+
+	uint					m_iCapacity;
+
+	//slot the next transition is written to
+	uint					m_iHead;
+
+	//number of valid transitions (up to the capacity)
+	uint					m_iSize;
+
+	//sort keys of the current sample: arena position << 32 | slot
+	std::vector<uint64_t>	m_vecKeys;
+
+public:
+	CReplayBuffer();
+
+	//(re)allocates the ring and empties it
+	void		Allocate(uint capacity);
+
+	void		Push(uint table, uint cell, uint action, float reward, uint nextCell,
+					 uint32_t cellGeneration = 0, uint32_t nextGeneration = 0)
+	{
+		m_vecTable[m_iHead] = table;
+		m_vecCell[m_iHead] = cell;
+		m_vecAction[m_iHead] = (uint8_t)action;
+		m_vecReward[m_iHead] = reward;
+		m_vecNextCell[m_iHead] = nextCell;
+		m_vecCellGeneration[m_iHead] = cellGeneration;
+		m_vecNextGeneration[m_iHead] = nextGeneration;
+
+		if (++m_iHead == m_iCapacity) m_iHead = 0;
+		if (m_iSize < m_iCapacity) ++m_iSize;
+	}
+
+	//draws n slots uniformly (with replacement) and returns them sorted by
+	//table and cell; cellsPerTable turns (table, cell) into an arena position
+	const std::vector<uint64_t>& Sample(uint n, uint cellsPerTable, CRandomStream &rng);
+
+	//slot of a key returned by Sample()
+	static uint	Slot(uint64_t key){return (uint)(key & 0xFFFFFFFF);}
+
+	//-------------------accessor functions
+	uint		Table(uint slot)const{return m_vecTable[slot];}
+	uint		Cell(uint slot)const{return m_vecCell[slot];}
+	uint		Action(uint slot)const{return m_vecAction[slot];}
+	float		Reward(uint slot)const{return m_vecReward[slot];}
+	uint		NextCell(uint slot)const{return m_vecNextCell[slot];}
+	uint32_t	CellGeneration(uint slot)const{return m_vecCellGeneration[slot];}
+	uint32_t	NextGeneration(uint slot)const{return m_vecNextGeneration[slot];}
+
+	uint		Size()const{return m_iSize;}
+	uint		Capacity()const{return m_iCapacity;}
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "CScenario.h"
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+#include "CParams.h"
+#include "CRandom.h"
+#include "CCollisionObject.h"
+
+CScenarioBank::CScenarioBank()
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+}
+
+size_t CScenarioBank::LayoutBytes(int world, size_t objects, size_t sweepers)
+{
+	size_t value = world == DiscreteTrace ? sizeof(int32_t) : sizeof(double);
+	size_t bytes = (2 * objects + 3 * sweepers) * value + objects;
+
+	return (bytes + 7) & ~(size_t)7;
+}
+
+bool CScenarioBank::Open(const char* szFileName)
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+
+	if (!m_File.Open(szFileName) || m_File.Size() < sizeof(SScenarioHeader)) return false;
+
+	SScenarioHeader header;
+	memcpy(&header, m_File.Data(), sizeof(header));
+
+	if (memcmp(header.magic, "SWSC", 4) != 0 || header.version != SCENARIO_VERSION ||
+		(header.world != DiscreteTrace && header.world != ContinuousTrace) || header.numLayouts == 0)
+	{
+		m_File.Close();
+
+		return false;
+	}
+
+	size_t objects = (size_t)header.numMines + header.numSuperMines + header.numRocks;
+
+	if (header.layoutBytes != LayoutBytes(header.world, objects, header.numSweepers) ||
+		m_File.Size() < sizeof(header) + (size_t)header.numLayouts * header.layoutBytes)
+	{
+		m_File.Close();
+
+		return false;
+	}
+
+	m_Header = header;
+
+	return true;
+}
+
+//-------------------------------FillLayout()-------------------------------
+//
+//	the objects in the order the controllers add them (mines, supermines,
+//	rocks), drawn like their Initialize functions, then the spawns drawn
+//	like a sweeper reset
+//
+//------------------------------------------------------------------------
+template <class T>
+static void FillLayout(T* values, uint8_t* types, const SScenarioHeader &header, CRandomStream &rng)
+{
+	size_t objects = (size_t)header.numMines + header.numSuperMines + header.numRocks;
+
+	T* objectX = values;
+	T* objectY = values + objects;
+	T* spawnX = values + 2 * objects;
+	T* spawnY = spawnX + header.numSweepers;
+	T* spawnRotation = spawnY + header.numSweepers;
+
+	for (size_t i = 0; i < objects; ++i)
+	{
+		if (i < header.numMines)
+			types[i] = CCollisionObject::Mine;
+		else if (i < header.numMines + header.numSuperMines)
+			types[i] = CCollisionObject::SuperMine;
+		else
+			types[i] = CCollisionObject::Rock;
+
+		if (header.world == DiscreteTrace)
+		{
+			objectX[i] = (T)(rng.RandInt(0, header.worldWidth / header.gridCellDim) * header.gridCellDim);
+			objectY[i] = (T)(rng.RandInt(0, header.worldHeight / header.gridCellDim) * header.gridCellDim);
+		}
+		else
+		{
+			objectX[i] = (T)(rng.RandFloat() * header.worldWidth);
+			objectY[i] = (T)(rng.RandFloat() * header.worldHeight);
+		}
+	}
+
+	for (size_t i = 0; i < header.numSweepers; ++i)
+	{
+		if (header.world == DiscreteTrace)
+		{
+			spawnX[i] = (T)(rng.RandInt(0, header.worldWidth / header.gridCellDim) * header.gridCellDim);
+			spawnY[i] = (T)(rng.RandInt(0, header.worldHeight / header.gridCellDim) * header.gridCellDim);
+			spawnRotation[i] = (T)rng.RandInt(0, 3);
+		}
+		else
+		{
+			spawnX[i] = (T)(rng.RandFloat() * header.worldWidth);
+			spawnY[i] = (T)(rng.RandFloat() * header.worldHeight);
+			spawnRotation[i] = (T)(rng.RandFloat() * CParams::dTwoPi);
+		}
+	}
+}
+
+//---------------------------GenerateScenarioBank()-------------------------
+//
+//	written a layout at a time, so a bank can be bigger than memory
+//
+//------------------------------------------------------------------------
+bool GenerateScenarioBank(const char* szFileName, TraceWorld world, uint numLayouts)
+{
+	SScenarioHeader header;
+	memset(&header, 0, sizeof(header));
+
+	memcpy(header.magic, "SWSC", 4);
+	header.version = SCENARIO_VERSION;
+	header.world = world;
+	header.seed = (uint32_t)CRandomService::MasterSeed();
+	header.numLayouts = numLayouts;
+	header.numSweepers = CParams::iNumSweepers;
+	header.numMines = CParams::iNumMines;
+	header.numSuperMines = CParams::iNumSuperMines;
+	header.numRocks = CParams::iNumRocks;
+	header.gridCellDim = CParams::iGridCellDim;
+
+	//the continuous world is the window
+	header.worldWidth = world == DiscreteTrace ? CParams::WorldWidth : CParams::WindowWidth;
+	header.worldHeight = world == DiscreteTrace ? CParams::WorldHeight : CParams::WindowHeight;
+
+	size_t objects = (size_t)header.numMines + header.numSuperMines + header.numRocks;
+	header.layoutBytes = (uint32_t)CScenarioBank::LayoutBytes(world, objects, header.numSweepers);
+
+	FILE* file = fopen(szFileName, "wb");
+
+	if (!file) return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	//uint64_t elements keep the buffer 8 byte aligned for the doubles
+	std::vector<uint64_t> buffer((header.layoutBytes + 7) / 8);
+
+	for (uint layout = 0; ok && layout < numLayouts; ++layout)
+	{
+		CRandomStream rng = CRandomService::Stream(CRandomService::Scenario, layout);
+		char* bytes = (char*)&buffer[0];
+
+		memset(bytes, 0, header.layoutBytes);
+
+		if (world == DiscreteTrace)
+			FillLayout((int32_t*)bytes, (uint8_t*)bytes + (2 * objects + 3 * header.numSweepers) * sizeof(int32_t), header, rng);
+		else
+			FillLayout((double*)bytes, (uint8_t*)bytes + (2 * objects + 3 * header.numSweepers) * sizeof(double), header, rng);
+
+		ok = fwrite(bytes, 1, header.layoutBytes, file) == header.layoutBytes;
+	}
+
+	return (fclose(file) == 0) && ok;
+}
@@ -0,0 +1,110 @@
+#ifndef CSCENARIO_H
+#define CSCENARIO_H
+//------------------------------------------------------------------------
+//
+//	Name: CScenario.h
+//
+//  Desc: Banks of pre-generated world layouts. A layout is where every
+//        object sits (and what it is) and where every sweeper starts, and
+//        a bank holds any number of them for one world: its kind, size,
+//        object counts and number of sweepers. With a bank (bUseScenarios)
+//        every episode starts from the next layout in turn instead of a
+//        random one, so runs on the same bank start from the same worlds.
+//
+//        File layout: a 64 byte header, then the layouts one after the
+//        other, all the same size. A layout is stored the way the pools
+//        keep it,
+//
+//          T objectX[objects], T objectY[objects],
+//          T spawnX[sweepers], T spawnY[sweepers], T spawnRotation[sweepers],
+//          uint8 objectType[objects], padding to 8 bytes
+//
+//        with T int32 (pixels, headings 0-3) for the discrete world and
+//        double for the continuous one, in the native byte order. The bank
+//        is memory mapped, so switching layouts is a memcpy per array
+//        straight from the file cache.
+//
+//------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include "CMappedFile.h"
+#include "CTrace.h"
+
+const uint32_t SCENARIO_VERSION = 1;
+
+struct SScenarioHeader
+{
+	char		magic[4];		//"SWSC"
+	uint32_t	version;
+	uint32_t	world;			//TraceWorld
+	uint32_t	seed;			//master seed the layouts were drawn with
+	uint32_t	numLayouts;
+	uint32_t	layoutBytes;
+	uint32_t	numSweepers;
+	uint32_t	numMines;
+	uint32_t	numSuperMines;
+	uint32_t	numRocks;
+	uint32_t	worldWidth;		//pixels
+	uint32_t	worldHeight;
+	uint32_t	gridCellDim;
+	uint32_t	reserved[3];
+};
+
+//one layout of a bank, pointing into the mapping
+template <class T>
+struct SScenarioLayout
+{
+	const T*		objectX;
+	const T*		objectY;
+	const T*		spawnX;
+	const T*		spawnY;
+	const T*		spawnRotation;
+	const uint8_t*	objectType;
+};
+
+class CScenarioBank
+{
+private:
+	CMappedFile		m_File;
+	SScenarioHeader	m_Header;
+
+public:
+	CScenarioBank();
+
+	//maps a bank, returns false if it cannot be read or is not a whole bank
+	bool		Open(const char* szFileName);
+
+	//layout i (0 <= i < NumLayouts()), with T matching the bank's world
+	template <class T>
+	SScenarioLayout<T>	Layout(int index)const
+	{
+		size_t objects = NumObjects();
+		const T* values = (const T*)(m_File.Data() + sizeof(SScenarioHeader) + (size_t)index * m_Header.layoutBytes);
+
+		SScenarioLayout<T> layout;
+		layout.objectX = values;
+		layout.objectY = values + objects;
+		layout.spawnX = values + 2 * objects;
+		layout.spawnY = layout.spawnX + m_Header.numSweepers;
+		layout.spawnRotation = layout.spawnY + m_Header.numSweepers;
+		layout.objectType = (const uint8_t*)(layout.spawnRotation + m_Header.numSweepers);
+
+		return layout;
+	}
+
+	//-------------------accessor functions
+	const SScenarioHeader&	Header()const{return m_Header;}
+	int			NumLayouts()const{return (int)m_Header.numLayouts;}
+	size_t		NumObjects()const{return (size_t)m_Header.numMines + m_Header.numSuperMines + m_Header.numRocks;}
+
+	//bytes of one layout of a world (padded to 8)
+	static size_t	LayoutBytes(int world, size_t objects, size_t sweepers);
+};
+
+//draws a bank of layouts for the world the params file describes, the
+//same way the controllers place a random world (layout i comes from its
+//own stream, so a bigger bank starts with the layouts of a smaller one).
+//Returns false if the file cannot be written
+bool GenerateScenarioBank(const char* szFileName, TraceWorld world, uint numLayouts);
+
+#endif
@@ -0,0 +1,370 @@
+#include "CSpatialGrid.h"
+#include "CRandom.h"
+#include "utils.h"
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+
+//positions go into cells through a multiply by the reciprocal, which can
+//round a point on a cell edge into the next cell over. A ring is only
+//ruled out when it is clear of the best distance by more than that
+const double RING_SLACK = 1e-6;
+
+//a candidate further than the best by this factor (squared) cannot tie it
+//once both are rounded through the square root, so it is never measured
+const double SQ_MARGIN = 1 + 1e-9;
+
+int CSpatialGrid::SLayer::CellX(double x)const
+{
+	double cell = x * invCellDim;
+
+	if (!(cell > 0)) return 0;
+	if (cell >= cellsX) return cellsX - 1;
+
+	return (int)cell;
+}
+
+int CSpatialGrid::SLayer::CellY(double y)const
+{
+	double cell = y * invCellDim;
+
+	if (!(cell > 0)) return 0;
+	if (cell >= cellsY) return cellsY - 1;
+
+	return (int)cell;
+}
+
+double CSpatialGrid::SLayer::GapX(int x, double px)const
+{
+	if (x > 0 && px < x * cellDim) return x * cellDim - px;
+	if (x < cellsX - 1 && px > (x + 1) * cellDim) return px - (x + 1) * cellDim;
+
+	return 0;
+}
+
+double CSpatialGrid::SLayer::GapY(int y, double py)const
+{
+	if (y > 0 && py < y * cellDim) return y * cellDim - py;
+	if (y < cellsY - 1 && py > (y + 1) * cellDim) return py - (y + 1) * cellDim;
+
+	return 0;
+}
+
+CSpatialGrid::CSpatialGrid(): m_dWidth(0),
+							  m_dHeight(0)
+{
+	for (int type = 0; type < CCollisionObject::NUM_OBJECT_TYPES; ++type)
+	{
+		SizeLayer(m_Layer[type], 0);
+	}
+}
+
+//-------------------------------SizeLayer()--------------------------------
+//
+//	square cells with about one object to a cell
+//
+//-------------------------------------------------------------------------
+void CSpatialGrid::SizeLayer(SLayer &layer, int objects)
+{
+	double area = m_dWidth * m_dHeight;
+
+	layer.cellDim = area > 0 ? sqrt(area / (objects > 1 ? objects : 1)) : 1;
+	layer.invCellDim = 1 / layer.cellDim;
+	layer.cellsX = std::max(1, (int)ceil(m_dWidth * layer.invCellDim));
+	layer.cellsY = std::max(1, (int)ceil(m_dHeight * layer.invCellDim));
+	layer.live = 0;
+
+	layer.head.assign((size_t)layer.cellsX * layer.cellsY, -1);
+}
+
+void CSpatialGrid::FillLayer(const CContObjectPool &objects, int type)
+{
+	SLayer &layer = m_Layer[type];
+
+	for (int i = 0; i < (int)objects.size(); ++i)
+	{
+		if (objects.Type(i) != type) continue;
+
+		m_vecCell[i] = -1;
+
+		if (objects.Alive(i)) Link(layer, i, layer.Cell(objects.Position(i)));
+	}
+}
+
+void CSpatialGrid::Link(SLayer &layer, int index, int cell)
+{
+	int first = layer.head[cell];
+
+	m_vecPrev[index] = -1;
+	m_vecNext[index] = first;
+	if (first != -1) m_vecPrev[first] = index;
+
+	layer.head[cell] = index;
+	m_vecCell[index] = cell;
+	++layer.live;
+}
+
+void CSpatialGrid::Unlink(SLayer &layer, int index)
+{
+	int prev = m_vecPrev[index];
+	int next = m_vecNext[index];
+
+	if (prev != -1) m_vecNext[prev] = next; else layer.head[m_vecCell[index]] = next;
+	if (next != -1) m_vecPrev[next] = prev;
+
+	m_vecCell[index] = -1;
+	--layer.live;
+}
+
+//---------------------------------Build()----------------------------------
+//
+//	the layers are sized by how many objects there are of each type, dead
+//	or alive, so rebuilding the same world reuses the same cells
+//
+//-------------------------------------------------------------------------
+void CSpatialGrid::Build(const CContObjectPool &objects, double width, double height)
+{
+	m_dWidth = width;
+	m_dHeight = height;
+
+	int counts[CCollisionObject::NUM_OBJECT_TYPES] = {0};
+
+	for (int i = 0; i < (int)objects.size(); ++i)
+	{
+		++counts[objects.Type(i)];
+	}
+
+	m_vecNext.resize(objects.size());
+	m_vecPrev.resize(objects.size());
+	m_vecCell.resize(objects.size());
+
+	for (int type = 0; type < CCollisionObject::NUM_OBJECT_TYPES; ++type)
+	{
+		SizeLayer(m_Layer[type], counts[type]);
+		FillLayer(objects, type);
+	}
+}
+
+void CSpatialGrid::Move(const CContObjectPool &objects, int index)
+{
+	SLayer &layer = m_Layer[objects.Type(index)];
+
+	if (m_vecCell[index] != -1) Unlink(layer, index);
+
+	if (objects.Alive(index)) Link(layer, index, layer.Cell(objects.Position(index)));
+}
+
+void CSpatialGrid::Remove(const CContObjectPool &objects, int index)
+{
+	if (m_vecCell[index] == -1) return;
+
+	int type = objects.Type(index);
+	SLayer &layer = m_Layer[type];
+
+	Unlink(layer, index);
+
+	//with a quarter as many objects as cells the rings get long; halving
+	//the count at least between rebuilds keeps them cheap overall
+	if (layer.live * 4 < layer.cellsX * layer.cellsY)
+	{
+		SizeLayer(layer, layer.live);
+		FillLayer(objects, type);
+	}
+}
+
+//-------------------------------ScanCell()---------------------------------
+//
+//	Vec2DLength exactly as the scan measured it, with its tie break
+//
+//-------------------------------------------------------------------------
+void CSpatialGrid::ScanCell(const CContObjectPool &objects, SVector2D<double> point, int first,
+							double gapX, double gapY, int &best, double &bestLength, double &bestSq)const
+{
+	if (first == -1) return;
+
+	if (best != -1)
+	{
+		double reach = bestLength + RING_SLACK;
+
+		if (gapX * gapX + gapY * gapY > reach * reach) return;
+	}
+
+	for (int i = first; i != -1; i = m_vecNext[i])
+	{
+		SVector2D<double> toObject = objects.Position(i) - point;
+		double sq = toObject.x * toObject.x + toObject.y * toObject.y;
+
+		if (best != -1 && sq > bestSq * SQ_MARGIN) continue;
+
+		double length = Vec2DLength<double>(toObject);
+
+		if (best == -1 || length < bestLength || (length == bestLength && i < best))
+		{
+			best = i;
+			bestLength = length;
+			bestSq = sq;
+		}
+	}
+}
+
+//--------------------------------Closest()---------------------------------
+//
+//	ring r is the square of cells r cells out from the point's cell. The
+//	point is inside its own cell, so everything in ring r is at least r - 1
+//	cells away
+//
+//-------------------------------------------------------------------------
+bool CSpatialGrid::Closest(const CContObjectPool &objects, int type, SVector2D<double> point,
+						   int &index, double &distance)const
+{
+	const SLayer &layer = m_Layer[type];
+
+	if (layer.live == 0) return false;
+
+	int cx = layer.CellX(point.x);
+	int cy = layer.CellY(point.y);
+	int lastRing = std::max(std::max(cx, layer.cellsX - 1 - cx), std::max(cy, layer.cellsY - 1 - cy));
+
+	int best = -1;
+	double bestLength = 0, bestSq = 0;
+
+	for (int ring = 0; ring <= lastRing; ++ring)
+	{
+		if (best != -1 && (ring - 1) * layer.cellDim - RING_SLACK > bestLength) break;
+
+		int x0 = std::max(cx - ring, 0), x1 = std::min(cx + ring, layer.cellsX - 1);
+		int y0 = std::max(cy - ring, 0), y1 = std::min(cy + ring, layer.cellsY - 1);
+
+		for (int y = y0; y <= y1; ++y)
+		{
+			const int* row = &layer.head[(size_t)y * layer.cellsX];
+			double gapY = layer.GapY(y, point.y);
+
+			if (y == cy - ring || y == cy + ring)
+			{
+				//top or bottom edge of the ring, every cell
+				for (int x = x0; x <= x1; ++x)
+				{
+					ScanCell(objects, point, row[x], layer.GapX(x, point.x), gapY, best, bestLength, bestSq);
+				}
+			}
+			else
+			{
+				//the sides, one cell each
+				if (cx - ring >= 0)
+					ScanCell(objects, point, row[cx - ring], layer.GapX(cx - ring, point.x), gapY, best, bestLength, bestSq);
+				if (cx + ring < layer.cellsX)
+					ScanCell(objects, point, row[cx + ring], layer.GapX(cx + ring, point.x), gapY, best, bestLength, bestSq);
+			}
+		}
+	}
+
+	index = best;
+	distance = bestLength;
+
+	return true;
+}
+
+size_t CSpatialGrid::Bytes()const
+{
+	size_t bytes = (m_vecNext.size() + m_vecPrev.size() + m_vecCell.size()) * sizeof(int);
+
+	for (int type = 0; type < CCollisionObject::NUM_OBJECT_TYPES; ++type)
+	{
+		bytes += m_Layer[type].head.size() * sizeof(int);
+	}
+
+	return bytes;
+}
+
+//-----------------------BenchmarkSpatialGrid------------------------------
+//
+//	mines at random positions and random query points. Moves respawn random
+//	mines somewhere else, like sweepers finding them
+//
+//-------------------------------------------------------------------------
+void BenchmarkSpatialGrid(double width, double height, int numObjects, uint queries)
+{
+	CRandomStream rng(12345);
+
+	CContObjectPool objects;
+	for (int i = 0; i < numObjects; ++i)
+	{
+		objects.Add(CCollisionObject::Mine, SVector2D<double>(rng.RandFloat() * width, rng.RandFloat() * height));
+	}
+
+	CSpatialGrid grid;
+
+	double start = HighResTime();
+	grid.Build(objects, width, height);
+	double buildTime = HighResTime() - start;
+
+	std::vector<SVector2D<double> > points(queries);
+	for (uint q = 0; q < queries; ++q)
+	{
+		points[q] = SVector2D<double>(rng.RandFloat() * width, rng.RandFloat() * height);
+	}
+
+	//the scan is linear in the objects, so it gets fewer queries
+	uint scanQueries = queries / (1 + numObjects / 1000);
+	if (scanQueries == 0) scanQueries = 1;
+
+	std::vector<int> scanNearest(scanQueries, -1);
+
+	start = HighResTime();
+	for (uint q = 0; q < scanQueries; ++q)
+	{
+		double closest = 99999;
+
+		for (int i = 0; i < numObjects; ++i)
+		{
+			double length = Vec2DLength<double>(objects.Position(i) - points[q]);
+
+			if (length < closest)
+			{
+				closest = length;
+				scanNearest[q] = i;
+			}
+		}
+	}
+	double scanTime = HighResTime() - start;
+
+	long checksum = 0;
+	bool match = true;
+
+	start = HighResTime();
+	for (uint q = 0; q < queries; ++q)
+	{
+		int nearest = -1;
+		double distance;
+
+		grid.Closest(objects, CCollisionObject::Mine, points[q], nearest, distance);
+
+		checksum += nearest;
+		if (q < scanQueries && nearest != scanNearest[q]) match = false;
+	}
+	double gridTime = HighResTime() - start;
+
+	int moves = numObjects < 100000 ? numObjects : 100000;
+
+	start = HighResTime();
+	for (int k = 0; k < moves; ++k)
+	{
+		int index = rng.RandInt(0, numObjects - 1);
+
+		objects.SetPosition(index, SVector2D<double>(rng.RandFloat() * width, rng.RandFloat() * height));
+		grid.Move(objects, index);
+	}
+	double moveTime = HighResTime() - start;
+
+	std::cout << "Spatial grid, " << width << "x" << height << " world, " << numObjects << " objects:" << std::endl;
+	std::cout << "  build:          " << buildTime * 1e6 << " us" << std::endl;
+	std::cout << "  scan query:     " << scanTime / scanQueries * 1e9 << " ns" << std::endl;
+	std::cout << "  grid query:     " << gridTime / queries * 1e9 << " ns" << std::endl;
+	if (moves > 0)
+	{
+		std::cout << "  move object:    " << moveTime / moves * 1e9 << " ns" << std::endl;
+	}
+	std::cout << "  grid " << (match ? "matches" : "DOES NOT MATCH") << " the scan"
+			  << " (checksum " << checksum << ")" << std::endl;
+}
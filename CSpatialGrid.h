@@ -0,0 +1,110 @@
+#ifndef CSPATIALGRID_H
+#define CSPATIALGRID_H
+//------------------------------------------------------------------------
+//
+//	Name: CSpatialGrid.h
+//
+//  Desc: Uniform grid over the continuous world's live objects, one layer
+//        per object type. Each layer has its own cell size, picked so an
+//        average cell holds about one object of that type, and keeps an
+//        intrusive doubly linked list per cell, so moving or removing an
+//        object is a couple of index writes and never allocates.
+//
+//        Closest searches rings of cells outwards from the query point's
+//        cell and stops once a ring cannot hold anything nearer than the
+//        best so far, so a query looks at a handful of objects however
+//        many there are. Candidates are compared by squared distance and
+//        only the ones that can win get a square root. The result is
+//        exactly what a scan of every object in index order finds: the
+//        same Vec2DLength, and a tie goes to the lower index.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <stddef.h>
+#include "SVector2D.h"
+#include "CContCollisionObject.h"
+
+typedef unsigned int uint;
+
+class CSpatialGrid
+{
+private:
+	struct SLayer
+	{
+		double				cellDim;
+		double				invCellDim;
+		int					cellsX;
+		int					cellsY;
+
+		//objects of the type in the layer (the live ones)
+		int					live;
+
+		//first object in each cell, -1 if it is empty. Cells are row major
+		std::vector<int>	head;
+
+		int		CellX(double x)const;
+		int		CellY(double y)const;
+		int		Cell(SVector2D<double> position)const{return CellY(position.y) * cellsX + CellX(position.x);}
+
+		//how far a coordinate is outside a column or row of cells. The edge
+		//cells reach out forever, since anything past the edge goes in them
+		double	GapX(int x, double px)const;
+		double	GapY(int y, double py)const;
+	};
+
+	double				m_dWidth;
+	double				m_dHeight;
+
+	SLayer				m_Layer[CCollisionObject::NUM_OBJECT_TYPES];
+
+	//list links of every object, and the cell it is linked into (-1 while
+	//it is out of the grid)
+	std::vector<int>	m_vecNext;
+	std::vector<int>	m_vecPrev;
+	std::vector<int>	m_vecCell;
+
+	//sizes a layer for a number of objects and empties it
+	void	SizeLayer(SLayer &layer, int objects);
+
+	//links the live objects of one type into their layer
+	void	FillLayer(const CContObjectPool &objects, int type);
+
+	void	Link(SLayer &layer, int index, int cell);
+	void	Unlink(SLayer &layer, int index);
+
+	//tests the objects of one cell against the best so far, unless the
+	//cell is gapX, gapY away from the point and so too far to hold anything
+	//nearer
+	void	ScanCell(const CContObjectPool &objects, SVector2D<double> point, int first,
+					 double gapX, double gapY, int &best, double &bestLength, double &bestSq)const;
+
+public:
+	CSpatialGrid();
+
+	//indexes the live objects of a pool over a width x height world.
+	//Anything outside the world goes in the nearest edge cell
+	void	Build(const CContObjectPool &objects, double width, double height);
+
+	//a live object has been moved (a mine respawning)
+	void	Move(const CContObjectPool &objects, int index);
+
+	//an object has died (a supermine). A layer that has lost most of its
+	//objects is rebuilt coarser, so searches stay short
+	void	Remove(const CContObjectPool &objects, int index);
+
+	//the closest live object of a type to a point and its distance. False
+	//(and index and distance untouched) if there is none
+	bool	Closest(const CContObjectPool &objects, int type, SVector2D<double> point,
+					int &index, double &distance)const;
+
+	//bytes held by the grid
+	size_t	Bytes()const;
+};
+
+//times closest object queries against the grid and against a scan of
+//every object (the old per-sweeper search), plus moving objects, on a
+//width x height world with the given number of objects of one type.
+//Also checks the grid finds what the scan does
+void BenchmarkSpatialGrid(double width, double height, int numObjects, uint queries);
+
+#endif
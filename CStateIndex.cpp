@@ -0,0 +1,172 @@
+#include "CStateIndex.h"
+
+const uint32_t CStateIndex::NONE;
+
+CStateIndex::CStateIndex(): m_iSlotMask(0),
+							m_iMaxCells(0),
+							m_iUsedCells(0),
+							m_iClockHand(0),
+							m_iTick(1),
+							m_iLookups(0),
+							m_iProbes(0),
+							m_iMaxProbe(0),
+							m_iEvictions(0)
+{
+}
+
+//-------------------------------Allocate()--------------------------------
+//
+//	at least twice as many slots as cells, so the load factor never goes
+//	above one half
+//
+//-------------------------------------------------------------------------
+void CStateIndex::Allocate(uint maxCells)
+{
+	uint slots = 2;
+	while (slots < 2 * maxCells) slots <<= 1;
+
+	m_vecSlotKey.assign(slots, 0);
+	m_vecSlotCell.assign(slots, NONE);
+	m_iSlotMask = slots - 1;
+
+	m_vecCellKey.assign(maxCells, 0);
+	m_vecReferenced.assign(maxCells, 0);
+	m_vecPinned.assign(maxCells, 0);
+	m_vecGeneration.assign(maxCells, 0);
+	m_iTick = 1;
+	m_iMaxCells = maxCells;
+	m_iUsedCells = 0;
+	m_iClockHand = 0;
+
+	m_iLookups = 0;
+	m_iProbes = 0;
+	m_iMaxProbe = 0;
+	m_iEvictions = 0;
+}
+
+//---------------------------------Lookup()--------------------------------
+//
+//	linear probe from the key's home slot until the key or an empty slot
+//
+//-------------------------------------------------------------------------
+uint CStateIndex::Lookup(uint64_t key, bool &fresh)
+{
+	++m_iLookups;
+
+	uint slot = Home(key);
+	uint probes = 1;
+
+	while (m_vecSlotCell[slot] != NONE)
+	{
+		if (m_vecSlotKey[slot] == key)
+		{
+			uint cell = m_vecSlotCell[slot];
+
+			m_vecReferenced[cell] = 1;
+			m_vecPinned[cell] = m_iTick;
+			m_iProbes += probes;
+			if (probes > m_iMaxProbe) m_iMaxProbe = probes;
+
+			fresh = false;
+			return cell;
+		}
+
+		slot = (slot + 1) & m_iSlotMask;
+		++probes;
+	}
+
+	m_iProbes += probes;
+	if (probes > m_iMaxProbe) m_iMaxProbe = probes;
+
+	//a new state: take a free cell or evict one
+	uint cell;
+
+	if (m_iUsedCells < m_iMaxCells)
+	{
+		cell = m_iUsedCells++;
+	}
+	else
+	{
+		cell = Evict();
+
+		//the erase may have shifted entries into the probe path, so find
+		//the first empty slot again
+		slot = Home(key);
+		while (m_vecSlotCell[slot] != NONE) slot = (slot + 1) & m_iSlotMask;
+	}
+
+	m_vecSlotKey[slot] = key;
+	m_vecSlotCell[slot] = cell;
+	m_vecCellKey[cell] = key;
+	m_vecReferenced[cell] = 1;
+	m_vecPinned[cell] = m_iTick;
+
+	fresh = true;
+	return cell;
+}
+
+//---------------------------------Evict()---------------------------------
+//
+//	CLOCK: the hand clears reference bits as it passes and stops at the
+//	first cell whose bit is already clear and that is not pinned
+//
+//-------------------------------------------------------------------------
+uint CStateIndex::Evict(void)
+{
+	while (m_vecReferenced[m_iClockHand] || m_vecPinned[m_iClockHand] == m_iTick)
+	{
+		m_vecReferenced[m_iClockHand] = 0;
+		m_iClockHand = (m_iClockHand + 1) % m_iMaxCells;
+	}
+
+	uint victim = m_iClockHand;
+	m_iClockHand = (m_iClockHand + 1) % m_iMaxCells;
+
+	Erase(m_vecCellKey[victim]);
+	++m_vecGeneration[victim];
+	++m_iEvictions;
+
+	return victim;
+}
+
+//---------------------------------Erase()---------------------------------
+//
+//	backward shift deletion: every entry after the hole that may legally
+//	sit in it (its home slot is not between the hole and itself) moves
+//	back, until an empty slot ends the run
+//
+//-------------------------------------------------------------------------
+void CStateIndex::Erase(uint64_t key)
+{
+	uint hole = Home(key);
+
+	while (m_vecSlotKey[hole] != key || m_vecSlotCell[hole] == NONE)
+	{
+		hole = (hole + 1) & m_iSlotMask;
+	}
+
+	uint next = (hole + 1) & m_iSlotMask;
+
+	while (m_vecSlotCell[next] != NONE)
+	{
+		uint home = Home(m_vecSlotKey[next]);
+
+		//distance travelled from home, against the distance to the hole
+		if (((next - home) & m_iSlotMask) >= ((next - hole) & m_iSlotMask))
+		{
+			m_vecSlotKey[hole] = m_vecSlotKey[next];
+			m_vecSlotCell[hole] = m_vecSlotCell[next];
+			hole = next;
+		}
+
+		next = (next + 1) & m_iSlotMask;
+	}
+
+	m_vecSlotCell[hole] = NONE;
+}
+
+size_t CStateIndex::Bytes() const
+{
+	return m_vecSlotKey.size() * (sizeof(uint64_t) + sizeof(uint32_t)) +
+		   m_vecCellKey.size() * (sizeof(uint64_t) + sizeof(uint8_t) + 2 * sizeof(uint32_t));
+}
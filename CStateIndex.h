@@ -0,0 +1,111 @@
+#ifndef CSTATEINDEX_H
+#define CSTATEINDEX_H
+//------------------------------------------------------------------------
+//
+//	Name: CStateIndex.h
+//
+//  Desc: Open-addressing hash index from encoded states (64 bit keys) to
+//        Q table cells, for state encodings whose key space is far larger
+//        than the set of states ever visited.
+//
+//        The index holds at most a fixed number of cells (the memory cap)
+//        and hands each newly seen state the next free one. Once every
+//        cell is in use, a CLOCK (second chance) sweep evicts a state that
+//        has not been looked up since the hand last passed it, and its
+//        cell is reused - the caller clears the cell's Q values.
+//
+//        The cells looked up since the last BeginTick are pinned: the
+//        sweepers of a tick hold on to them until their updates are done,
+//        so they are never evicted under them. A cell's generation goes up
+//        every time it is evicted, so anything kept across ticks (traces,
+//        replayed transitions) can tell that its cell now means another
+//        state.
+//
+//        Slots are probed linearly in a power of two table kept at most
+//        half full, and deletions shift the following entries back, so no
+//        tombstones build up and probe lengths stay short.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+class CStateIndex
+{
+private:
+	//empty slot marker
+	static const uint32_t NONE = 0xFFFFFFFF;
+
+	//open addressing table: key and cell of each slot
+	std::vector<uint64_t>	m_vecSlotKey;
+	std::vector<uint32_t>	m_vecSlotCell;
+	uint					m_iSlotMask;
+
+	//key of each cell in use, its CLOCK reference bit, the tick it was
+	//last looked up in and how many times it has been evicted
+	std::vector<uint64_t>	m_vecCellKey;
+	std::vector<uint8_t>	m_vecReferenced;
+	std::vector<uint32_t>	m_vecPinned;
+	std::vector<uint32_t>	m_vecGeneration;
+	uint					m_iMaxCells;
+	uint					m_iUsedCells;
+	uint					m_iClockHand;
+	uint32_t				m_iTick;
+
+	//stats
+	uint64_t				m_iLookups;
+	uint64_t				m_iProbes;
+	uint					m_iMaxProbe;
+	uint64_t				m_iEvictions;
+
+	//home slot of a key (64 bit finalizer of splitmix64)
+	uint		Home(uint64_t key) const
+	{
+		key ^= key >> 30;
+		key *= 0xBF58476D1CE4E5B9ULL;
+		key ^= key >> 27;
+		key *= 0x94D049BB133111EBULL;
+		key ^= key >> 31;
+
+		return (uint)key & m_iSlotMask;
+	}
+
+	//removes a key from the slots, closing the gap it leaves behind
+	void		Erase(uint64_t key);
+
+	//picks the cell to reuse once every cell is taken, never a pinned one
+	uint		Evict(void);
+
+public:
+	CStateIndex();
+
+	//empties the index and sizes it for up to maxCells states
+	void		Allocate(uint maxCells);
+
+	//returns the cell of a state, giving it a cell if it has none yet,
+	//and pins it until the next BeginTick. fresh is set if the cell was
+	//(re)assigned by this call and so still holds the values of an
+	//evicted state. There must be fewer lookups between two BeginTicks
+	//than there are cells
+	uint		Lookup(uint64_t key, bool &fresh);
+
+	//unpins every cell
+	void		BeginTick(void){++m_iTick;}
+
+	//times a cell has been handed to a new state
+	uint32_t	Generation(uint cell)const{return m_vecGeneration[cell];}
+
+	//-------------------accessor functions
+	uint		MaxCells()const{return m_iMaxCells;}
+	uint		UsedCells()const{return m_iUsedCells;}
+	uint		NumSlots()const{return (uint)m_vecSlotKey.size();}
+	uint64_t	Lookups()const{return m_iLookups;}
+	uint64_t	Evictions()const{return m_iEvictions;}
+	uint		MaxProbe()const{return m_iMaxProbe;}
+	double		MeanProbe()const{return m_iLookups ? (double)m_iProbes / m_iLookups : 0;}
+	size_t		Bytes()const;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "CStatsWriter.h"
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+const uint32_t CStatsWriter::RING_SIZE;
+
+CStatsWriter::CStatsWriter():m_vecRing(RING_SIZE),
+							 m_iHead(0),
+							 m_iTail(0),
+							 m_pFile(NULL),
+							 m_iFormat(CsvStats),
+							 m_bFailed(false),
+							 m_bStop(false)
+{
+}
+
+CStatsWriter::~CStatsWriter()
+{
+	Close();
+}
+
+bool CStatsWriter::Open(const std::string &fileName, int format)
+{
+	Close();
+
+	m_pFile = fopen(fileName.c_str(), format == BinaryStats ? "wb" : "w");
+
+	if (!m_pFile) return false;
+
+	bool ok;
+
+	if (format == BinaryStats)
+	{
+		uint32_t header[4] = {0, STATS_VERSION, sizeof(SIterationStats), 0};
+		memcpy(header, "SWST", 4);
+
+		ok = fwrite(header, sizeof(header), 1, m_pFile) == 1;
+	}
+	else
+	{
+		ok = fputs("iteration,sweepers,deaths,average_mines,most_mines,mines_gathered\n", m_pFile) >= 0;
+	}
+
+	if (!ok)
+	{
+		fclose(m_pFile);
+		m_pFile = NULL;
+
+		return false;
+	}
+
+	m_sFileName = fileName;
+	m_iFormat = format;
+	m_iHead.store(0);
+	m_iTail.store(0);
+	m_bFailed.store(false);
+	m_bStop = false;
+
+	m_Thread = std::thread(&CStatsWriter::Run, this);
+
+	return true;
+}
+
+bool CStatsWriter::OpenNew(const std::string &baseName, const std::string &extension, int format)
+{
+	std::string fileName = baseName + extension;
+
+	for (int run = 1; ; ++run)
+	{
+		FILE* existing = fopen(fileName.c_str(), "rb");
+
+		if (!existing) break;
+
+		fclose(existing);
+
+		std::ostringstream name;
+		name << baseName << "-" << run << extension;
+		fileName = name.str();
+	}
+
+	return Open(fileName, format);
+}
+
+void CStatsWriter::Close()
+{
+	if (!m_Thread.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bStop = true;
+	}
+	m_Wake.notify_one();
+
+	m_Thread.join();
+
+	if (m_bFailed.load()) std::cout << "Could not write all the stats to " << m_sFileName << std::endl;
+}
+
+//--------------------------------Push()----------------------------------
+//
+//	the slot is filled before the head moves on (release), so the writer
+//	never sees a half written record
+//
+//------------------------------------------------------------------------
+void CStatsWriter::Push(const SIterationStats &stats)
+{
+	if (!m_Thread.joinable()) return;
+
+	uint32_t head = m_iHead.load(std::memory_order_relaxed);
+
+	while (head - m_iTail.load(std::memory_order_acquire) >= RING_SIZE)
+	{
+		m_Wake.notify_one();
+		std::this_thread::yield();
+	}
+
+	m_vecRing[head % RING_SIZE] = stats;
+	m_iHead.store(head + 1, std::memory_order_release);
+
+	if (head + 1 - m_iTail.load(std::memory_order_relaxed) >= RING_SIZE / 2) m_Wake.notify_one();
+}
+
+void CStatsWriter::Run()
+{
+	for (;;)
+	{
+		bool stop;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_Wake.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this]
+			{
+				return m_bStop || m_iHead.load(std::memory_order_relaxed) -
+								  m_iTail.load(std::memory_order_relaxed) >= RING_SIZE / 2;
+			});
+
+			stop = m_bStop;
+		}
+
+		//everything pushed before Close is in the ring by now, so this last
+		//drain misses nothing
+		Drain();
+
+		if (stop) break;
+	}
+
+	fclose(m_pFile);
+	m_pFile = NULL;
+}
+
+void CStatsWriter::Drain()
+{
+	uint32_t tail = m_iTail.load(std::memory_order_relaxed);
+	uint32_t head = m_iHead.load(std::memory_order_acquire);
+
+	if (tail == head) return;
+
+	m_sBatch.clear();
+
+	for (; tail != head; ++tail)
+	{
+		const SIterationStats &stats = m_vecRing[tail % RING_SIZE];
+
+		if (m_iFormat == BinaryStats)
+		{
+			m_sBatch.append((const char*)&stats, sizeof(stats));
+		}
+		else
+		{
+			char line[128];
+
+			int length = sprintf(line, "%d,%d,%d,%.10g,%d,%.10g\n", stats.iteration, stats.numSweepers,
+								 stats.deaths, stats.averageMines, stats.mostMines, stats.minesGathered);
+
+			m_sBatch.append(line, length);
+		}
+	}
+
+	//the slots can be reused once they have been copied out
+	m_iTail.store(tail, std::memory_order_release);
+
+	if (fwrite(m_sBatch.data(), 1, m_sBatch.size(), m_pFile) != m_sBatch.size() || fflush(m_pFile) != 0)
+	{
+		m_bFailed.store(true);
+	}
+}
@@ -0,0 +1,109 @@
+#ifndef CSTATSWRITER_H
+#define CSTATSWRITER_H
+//------------------------------------------------------------------------
+//
+//	Name: CStatsWriter.h
+//
+//  Desc: Writes the per iteration stats of a run on a background thread.
+//        The simulation thread drops each iteration's record into a fixed
+//        size single producer / single consumer ring - two atomic counters,
+//        no lock - and goes on. The writer thread wakes every so often (or
+//        as soon as the ring is half full), formats whatever has been
+//        queued and writes it with one fwrite.
+//
+//        One new file per run, either CSV (a header line, then a line per
+//        iteration) or binary (a 16 byte header, then the SIterationStats
+//        records as they are in memory). Close, and the destructor, write
+//        out everything queued before returning.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdio.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+const uint32_t STATS_VERSION = 1;
+
+enum StatsFormat { CsvStats, BinaryStats };
+
+struct SIterationStats
+{
+	int32_t		iteration;
+	int32_t		deaths;
+	int32_t		mostMines;
+	int32_t		numSweepers;
+	double		averageMines;
+	double		minesGathered;
+};
+
+class CStatsWriter
+{
+private:
+	//records the ring holds (a power of two) - the writer drains it long
+	//before a run can fill it
+	static const uint32_t RING_SIZE = 4096;
+
+	//how long the writer thread sleeps between batches, in milliseconds
+	static const int FLUSH_INTERVAL_MS = 250;
+
+	std::vector<SIterationStats>	m_vecRing;
+
+	//records pushed by the simulation thread and taken by the writer thread
+	//so far - the slot of a count is count % RING_SIZE
+	std::atomic<uint32_t>	m_iHead;
+	std::atomic<uint32_t>	m_iTail;
+
+	//------------------------------------writer thread only (while it runs)
+	FILE*					m_pFile;
+	int						m_iFormat;
+	std::string				m_sBatch;
+
+	//set by the writer thread when a write fails
+	std::atomic<bool>		m_bFailed;
+
+	std::string				m_sFileName;
+
+	bool					m_bStop;
+	std::mutex				m_Mutex;
+	std::condition_variable	m_Wake;
+	std::thread				m_Thread;
+
+	void		Run();
+
+	//writes out everything queued so far (writer thread)
+	void		Drain();
+
+	CStatsWriter(const CStatsWriter&);
+	CStatsWriter& operator=(const CStatsWriter&);
+
+public:
+	CStatsWriter();
+	~CStatsWriter();
+
+	//creates the file, writes its header and starts the writer thread.
+	//Returns false if the file cannot be created
+	bool		Open(const std::string &fileName, int format);
+
+	//opens baseName + extension, or if that file is already there the
+	//first of baseName-1, baseName-2, ... (plus extension) that is not, so
+	//a run never overwrites the stats of an earlier one
+	bool		OpenNew(const std::string &baseName, const std::string &extension, int format);
+
+	//writes out what is queued, closes the file and joins the thread
+	void		Close();
+
+	//queues an iteration's stats (simulation thread). Only waits if the
+	//ring is full, and does nothing if the writer is not open
+	void		Push(const SIterationStats &stats);
+
+	bool		IsOpen()const{return m_Thread.joinable();}
+	const std::string&	FileName()const{return m_sFileName;}
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include "CSweeperPool.h"
+#include "CParams.h"
+#include <string.h>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//unit step of each ROTATION_DIRECTION - the integer value of
+//(cos, sin)(direction * HalfPi). Repeated so that the AVX2 pass can use
+//the table as one register and index it with the rotations directly
+static const int32_t LookAtX[8] = {1, 0, -1, 0, 1, 0, -1, 0};
+static const int32_t LookAtY[8] = {0, 1, 0, -1, 0, 1, 0, -1};
+
+//--------------------------------Wrap------------------------------------
+//
+//	off the far edge goes back to 0, off the near edge to the last cell
+//	before the far edge - the same as the old four ifs, without branches
+//
+//------------------------------------------------------------------------
+static inline int32_t Wrap(int32_t position, int32_t limit, int32_t step)
+{
+	position = position >= limit ? 0 : position;
+
+	return position < 0 ? limit - step : position;
+}
+
+//the old sweepers drew their start cell inside one SVector2D constructor
+//call, which both compilers evaluate right to left - y is drawn first so
+//that a seed still spawns everyone on the same cells
+void CSweeperPool::Spawn(int index)
+{
+	m_vecY[index] = m_vecRng[index].RandInt(0,CParams::WorldHeight/CParams::iGridCellDim)*CParams::iGridCellDim;
+	m_vecX[index] = m_vecRng[index].RandInt(0,CParams::WorldWidth/CParams::iGridCellDim)*CParams::iGridCellDim;
+}
+
+int CSweeperPool::Add(const CRandomStream &rng)
+{
+	int index = (int)size();
+
+	m_vecRng.push_back(rng);
+	m_vecX.push_back(0);
+	m_vecY.push_back(0);
+	m_vecAlive.push_back(1);
+	m_vecMinesGathered.push_back(0);
+	m_vecActive.push_back(index);
+
+	//the rotation is drawn before the start cell
+	m_vecRotation.push_back(m_vecRng[index].RandInt(0,3));
+	Spawn(index);
+
+	return index;
+}
+
+void CSweeperPool::Clear()
+{
+	m_vecX.clear();
+	m_vecY.clear();
+	m_vecRotation.clear();
+	m_vecAlive.clear();
+	m_vecMinesGathered.clear();
+	m_vecRng.clear();
+	m_vecActive.clear();
+
+	m_iKilled = 0;
+}
+
+void CSweeperPool::Reset(int index)
+{
+	//the start cell is drawn before the rotation
+	Spawn(index);
+
+	m_vecMinesGathered[index] = 0;
+	m_vecAlive[index] = 1;
+
+	m_vecRotation[index] = m_vecRng[index].RandInt(0,3);
+}
+
+void CSweeperPool::ResetAll()
+{
+	m_vecActive.clear();
+
+	for (int i = 0; i < (int)size(); ++i)
+	{
+		Reset(i);
+		m_vecActive.push_back(i);
+	}
+
+	m_iKilled = 0;
+}
+
+void CSweeperPool::Place(int index, SVector2D<int> position, ROTATION_DIRECTION rotation)
+{
+	m_vecX[index] = position.x;
+	m_vecY[index] = position.y;
+	m_vecRotation[index] = rotation;
+	m_vecMinesGathered[index] = 0;
+	m_vecAlive[index] = 1;
+}
+
+void CSweeperPool::PlaceAll(const int32_t* x, const int32_t* y, const int32_t* rotation)
+{
+	if (m_vecX.empty()) return;
+
+	memcpy(&m_vecX[0], x, m_vecX.size() * sizeof(int32_t));
+	memcpy(&m_vecY[0], y, m_vecY.size() * sizeof(int32_t));
+	memcpy(&m_vecRotation[0], rotation, m_vecRotation.size() * sizeof(int32_t));
+
+	std::fill(m_vecAlive.begin(), m_vecAlive.end(), 1);
+	std::fill(m_vecMinesGathered.begin(), m_vecMinesGathered.end(), 0.0);
+
+	m_vecActive.resize(m_vecX.size());
+
+	for (int i = 0; i < (int)size(); ++i) m_vecActive[i] = i;
+
+	m_iKilled = 0;
+}
+
+void CSweeperPool::RebuildActive()
+{
+	m_vecActive.clear();
+
+	for (int i = 0; i < (int)size(); ++i)
+	{
+		if (m_vecAlive[i]) m_vecActive.push_back(i);
+	}
+
+	m_iKilled = 0;
+}
+
+//-------------------------------Move()-----------------------------------
+//
+//	dead sweepers take a zero step, so every lane can be processed the
+//	same way
+//
+//------------------------------------------------------------------------
+void CSweeperPool::Move(int first, int last)
+{
+	const int32_t step = CParams::iGridCellDim;
+	const int32_t width = CParams::WorldWidth;
+	const int32_t height = CParams::WorldHeight;
+
+	int32_t* x = m_vecX.empty() ? NULL : &m_vecX[0];
+	int32_t* y = m_vecY.empty() ? NULL : &m_vecY[0];
+	const int32_t* rotation = m_vecRotation.empty() ? NULL : &m_vecRotation[0];
+	const int32_t* alive = m_vecAlive.empty() ? NULL : &m_vecAlive[0];
+
+	int n = last;
+	int i = first;
+
+#if defined(__AVX2__)
+	const __m256i lookAtX = _mm256_loadu_si256((const __m256i*)LookAtX);
+	const __m256i lookAtY = _mm256_loadu_si256((const __m256i*)LookAtY);
+	const __m256i steps = _mm256_set1_epi32(step);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i lastX = _mm256_set1_epi32(width - 1);
+	const __m256i lastY = _mm256_set1_epi32(height - 1);
+	const __m256i wrapX = _mm256_set1_epi32(width - step);
+	const __m256i wrapY = _mm256_set1_epi32(height - step);
+
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i rot = _mm256_loadu_si256((const __m256i*)(rotation + i));
+		__m256i stride = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(alive + i)), steps);
+
+		__m256i px = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(x + i)),
+									  _mm256_mullo_epi32(_mm256_permutevar8x32_epi32(lookAtX, rot), stride));
+		__m256i py = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(y + i)),
+									  _mm256_mullo_epi32(_mm256_permutevar8x32_epi32(lookAtY, rot), stride));
+
+		//past the far edge -> 0, then below 0 -> the last cell
+		px = _mm256_andnot_si256(_mm256_cmpgt_epi32(px, lastX), px);
+		py = _mm256_andnot_si256(_mm256_cmpgt_epi32(py, lastY), py);
+		px = _mm256_blendv_epi8(px, wrapX, _mm256_cmpgt_epi32(zero, px));
+		py = _mm256_blendv_epi8(py, wrapY, _mm256_cmpgt_epi32(zero, py));
+
+		_mm256_storeu_si256((__m256i*)(x + i), px);
+		_mm256_storeu_si256((__m256i*)(y + i), py);
+	}
+#endif
+
+	//the rest (or everything without AVX2)
+	for (; i < n; ++i)
+	{
+		int32_t stride = alive[i] * step;
+
+		x[i] = Wrap(x[i] + LookAtX[rotation[i]] * stride, width, step);
+		y[i] = Wrap(y[i] + LookAtY[rotation[i]] * stride, height, step);
+	}
+}
+
+void CSweeperPool::Move(int index)
+{
+	m_vecX[index] = Wrap(m_vecX[index] + LookAtX[m_vecRotation[index]] * CParams::iGridCellDim,
+						 CParams::WorldWidth, CParams::iGridCellDim);
+	m_vecY[index] = Wrap(m_vecY[index] + LookAtY[m_vecRotation[index]] * CParams::iGridCellDim,
+						 CParams::WorldHeight, CParams::iGridCellDim);
+}
+
+//---------------------------CompactActive()------------------------------
+//
+//	stable, so the live sweepers are still visited in index order
+//
+//------------------------------------------------------------------------
+void CSweeperPool::CompactActive()
+{
+	if (m_iKilled == 0) return;
+
+	size_t kept = 0;
+
+	for (size_t k = 0; k < m_vecActive.size(); ++k)
+	{
+		m_vecActive[kept] = m_vecActive[k];
+		kept += m_vecAlive[m_vecActive[k]];
+	}
+
+	m_vecActive.resize(kept);
+
+	m_iKilled = 0;
+}
@@ -0,0 +1,109 @@
+#include "CThreadPool.h"
+
+CThreadPool::CThreadPool():m_pRun(NULL),
+						   m_pTask(NULL),
+						   m_iCount(0),
+						   m_iChunks(0),
+						   m_iGeneration(0),
+						   m_iPending(0),
+						   m_bStop(false)
+{
+}
+
+CThreadPool::~CThreadPool()
+{
+	Stop();
+}
+
+void CThreadPool::Start(int threads)
+{
+	Stop();
+
+	m_bStop = false;
+
+	for (int worker = 1; worker < threads; ++worker)
+	{
+		m_vecWorkers.push_back(std::thread(&CThreadPool::Run, this, worker));
+	}
+}
+
+void CThreadPool::Stop()
+{
+	if (m_vecWorkers.empty()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bStop = true;
+	}
+	m_Wake.notify_all();
+
+	for (size_t w = 0; w < m_vecWorkers.size(); ++w) m_vecWorkers[w].join();
+
+	m_vecWorkers.clear();
+}
+
+//-------------------------------Dispatch()--------------------------------
+//
+//	chunk c is [count * c / chunks, count * (c + 1) / chunks). The caller
+//	does chunk 0 while the workers do the rest
+//
+//-------------------------------------------------------------------------
+void CThreadPool::Dispatch(void (*run)(void*, uint, uint), void* task, uint count, uint chunks)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_pRun = run;
+		m_pTask = task;
+		m_iCount = count;
+		m_iChunks = chunks;
+		m_iPending = chunks - 1;
+		++m_iGeneration;
+	}
+	m_Wake.notify_all();
+
+	run(task, 0, (uint)((unsigned long long)count / chunks));
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while (m_iPending > 0) m_Done.wait(lock);
+}
+
+void CThreadPool::Run(uint worker)
+{
+	uint generation = 0;
+
+	while (true)
+	{
+		void (*run)(void*, uint, uint);
+		void* task;
+		uint count, chunks;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			while (!m_bStop && m_iGeneration == generation) m_Wake.wait(lock);
+
+			if (m_bStop) return;
+
+			generation = m_iGeneration;
+
+			//a job with fewer chunks than there are threads leaves some idle
+			if (worker >= m_iChunks) continue;
+
+			run = m_pRun;
+			task = m_pTask;
+			count = m_iCount;
+			chunks = m_iChunks;
+		}
+
+		run(task, (uint)((unsigned long long)count * worker / chunks),
+				  (uint)((unsigned long long)count * (worker + 1) / chunks));
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			if (--m_iPending == 0) m_Done.notify_one();
+		}
+	}
+}
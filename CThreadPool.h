@@ -0,0 +1,86 @@
+#ifndef CTHREADPOOL_H
+#define CTHREADPOOL_H
+//------------------------------------------------------------------------
+//
+//	Name: CThreadPool.h
+//
+//  Desc: Fork-join pool for splitting a tick's per sweeper work.
+//        ParallelFor splits a range into one contiguous chunk per thread -
+//        the caller takes the first one - and returns once every chunk is
+//        done. The chunks depend only on the range and the number of
+//        threads, never on timing, and the work handed out only ever
+//        writes to its own indices, so a parallel tick gives the same
+//        results as a serial one.
+//
+//        The workers sleep on a condition variable between jobs.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+typedef unsigned int uint;
+
+class CThreadPool
+{
+private:
+	std::vector<std::thread>	m_vecWorkers;
+
+	//------------------------------------shared, guarded by m_Mutex
+	//the job: called with a [begin, end) chunk of the range
+	void			(*m_pRun)(void* task, uint begin, uint end);
+	void*			m_pTask;
+	uint			m_iCount;
+	uint			m_iChunks;
+
+	//bumped for every job, so a worker can tell a new one from the last
+	uint			m_iGeneration;
+	uint			m_iPending;
+	bool			m_bStop;
+
+	std::mutex					m_Mutex;
+	std::condition_variable		m_Wake;
+	std::condition_variable		m_Done;
+
+	void		Run(uint worker);
+
+	void		Dispatch(void (*run)(void*, uint, uint), void* task, uint count, uint chunks);
+
+	template <class Task>
+	static void	Call(void* task, uint begin, uint end){(*(Task*)task)(begin, end);}
+
+	CThreadPool(const CThreadPool&);
+	CThreadPool& operator=(const CThreadPool&);
+
+public:
+	CThreadPool();
+	~CThreadPool();
+
+	//starts threads - 1 workers (the caller is the other thread), 0 or 1
+	//leaves the pool serial
+	void		Start(int threads);
+	void		Stop();
+
+	uint		Threads()const{return (uint)m_vecWorkers.size() + 1;}
+
+	//runs task(begin, end) over [0, count), in chunks of at least minChunk
+	//indices - a small range stays on the calling thread
+	template <class Task>
+	void		ParallelFor(uint count, uint minChunk, Task &task)
+	{
+		uint chunks = minChunk > 0 ? count / minChunk : count;
+
+		if (chunks > Threads()) chunks = Threads();
+
+		if (chunks <= 1)
+		{
+			task(0, count);
+			return;
+		}
+
+		Dispatch(&Call<Task>, &task, count, chunks);
+	}
+};
+
+#endif
@@ -0,0 +1,307 @@
+#include "CTrace.h"
+#include <string.h>
+
+//--------------------------------------------------------------------------
+//	CTraceWriter
+//--------------------------------------------------------------------------
+CTraceWriter::CTraceWriter():m_pFile(NULL),
+							 m_iIteration(0),
+							 m_bEpisodeOpen(false),
+							 m_iBytesWritten(0),
+							 m_iEpisodesWritten(0)
+{
+}
+
+CTraceWriter::~CTraceWriter()
+{
+	Close();
+}
+
+void CTraceWriter::Varint(std::vector<uint8_t> &out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+
+	out.push_back((uint8_t)value);
+}
+
+bool CTraceWriter::Open(const char* szFileName, const STraceHeader &header)
+{
+	Close();
+
+	m_pFile = fopen(szFileName, "wb");
+
+	if (!m_pFile) return false;
+
+	STraceHeader stamped = header;
+	memcpy(stamped.magic, "SWTR", 4);
+	stamped.version = TRACE_VERSION;
+
+	if (fwrite(&stamped, sizeof(stamped), 1, m_pFile) != 1 || fflush(m_pFile) != 0)
+	{
+		Close();
+
+		return false;
+	}
+
+	m_iBytesWritten = sizeof(stamped);
+	m_iEpisodesWritten = 0;
+
+	return true;
+}
+
+void CTraceWriter::Close()
+{
+	if (m_pFile) fclose(m_pFile);
+
+	m_pFile = NULL;
+	m_bEpisodeOpen = false;
+}
+
+void CTraceWriter::BeginEpisode(int iteration)
+{
+	m_vecEpisode.clear();
+	m_iIteration = iteration;
+	m_bEpisodeOpen = true;
+}
+
+void CTraceWriter::PutRaw(const void* data, size_t bytes)
+{
+	const uint8_t* p = (const uint8_t*)data;
+
+	m_vecEpisode.insert(m_vecEpisode.end(), p, p + bytes);
+}
+
+void CTraceWriter::BeginTick()
+{
+	m_vecEscapes.clear();
+}
+
+void CTraceWriter::PutSymbols(const int32_t* symbols, uint count)
+{
+	//0 ends the tick list, so the count is stored plus one
+	Varint(m_vecEpisode, (uint64_t)count + 1);
+
+	if (count == 0) return;
+
+	size_t base = m_vecEpisode.size();
+	m_vecEpisode.resize(base + (count + 3) / 4);
+
+	uint8_t* packed = &m_vecEpisode[base];
+	uint i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		*packed++ = (uint8_t)((symbols[i] & 3) | (symbols[i + 1] & 3) << 2 | (symbols[i + 2] & 3) << 4 | (symbols[i + 3] & 3) << 6);
+	}
+
+	if (i < count)
+	{
+		uint8_t last = 0;
+
+		for (uint shift = 0; i < count; ++i, shift += 2) last |= (uint8_t)((symbols[i] & 3) << shift);
+
+		*packed = last;
+	}
+}
+
+void CTraceWriter::PutEscape(const void* data, size_t bytes)
+{
+	const uint8_t* p = (const uint8_t*)data;
+
+	m_vecEscapes.insert(m_vecEscapes.end(), p, p + bytes);
+}
+
+void CTraceWriter::EndTick()
+{
+	if (!m_vecEscapes.empty()) m_vecEpisode.insert(m_vecEpisode.end(), m_vecEscapes.begin(), m_vecEscapes.end());
+}
+
+//-----------------------------EndEpisode()-------------------------------
+//
+//	the record header goes through the same varint encoding, then the
+//	buffered payload is written with a single fwrite
+//
+//------------------------------------------------------------------------
+bool CTraceWriter::EndEpisode(uint deaths, double minesGathered)
+{
+	if (!m_pFile || !m_bEpisodeOpen) return false;
+
+	m_bEpisodeOpen = false;
+
+	Varint(m_vecEpisode, 0);
+	Varint(m_vecEpisode, deaths);
+	PutRaw(&minesGathered, sizeof(minesGathered));
+
+	std::vector<uint8_t> record;
+	Varint(record, (uint64_t)m_iIteration);
+	Varint(record, m_vecEpisode.size());
+
+	bool ok = fwrite(&record[0], 1, record.size(), m_pFile) == record.size() &&
+			  fwrite(&m_vecEpisode[0], 1, m_vecEpisode.size(), m_pFile) == m_vecEpisode.size() &&
+			  fflush(m_pFile) == 0;
+
+	if (ok)
+	{
+		m_iBytesWritten += record.size() + m_vecEpisode.size();
+		++m_iEpisodesWritten;
+	}
+
+	return ok;
+}
+
+//--------------------------------------------------------------------------
+//	CTraceReader
+//--------------------------------------------------------------------------
+CTraceReader::CTraceReader():m_pCursor(NULL),
+							 m_pEnd(NULL),
+							 m_bFailed(false),
+							 m_pSymbols(NULL),
+							 m_iSymbol(0),
+							 m_iNumSymbols(0)
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+}
+
+bool CTraceReader::Varint(const uint8_t* &cursor, const uint8_t* end, uint64_t &value)
+{
+	value = 0;
+
+	for (int shift = 0; cursor < end && shift < 64; shift += 7)
+	{
+		uint8_t byte = *cursor++;
+
+		value |= (uint64_t)(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80)) return true;
+	}
+
+	return false;
+}
+
+//------------------------------Open()------------------------------------
+//
+//	read through stdio rather than mapped, so the GUI can open a trace its
+//	own recorder still has open for writing
+//
+//------------------------------------------------------------------------
+bool CTraceReader::Open(const char* szFileName)
+{
+	m_vecData.clear();
+	m_vecOffset.clear();
+	m_vecSize.clear();
+	m_vecIteration.clear();
+
+	FILE* file = fopen(szFileName, "rb");
+
+	if (!file) return false;
+
+	uint8_t buffer[65536];
+	size_t count;
+
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		m_vecData.insert(m_vecData.end(), buffer, buffer + count);
+	}
+
+	fclose(file);
+
+	if (m_vecData.size() < sizeof(STraceHeader)) return false;
+
+	memcpy(&m_Header, &m_vecData[0], sizeof(m_Header));
+
+	if (memcmp(m_Header.magic, "SWTR", 4) != 0 || m_Header.version != TRACE_VERSION) return false;
+
+	const uint8_t* cursor = &m_vecData[0] + sizeof(STraceHeader);
+	const uint8_t* end = &m_vecData[0] + m_vecData.size();
+
+	uint64_t iteration, size;
+
+	while (Varint(cursor, end, iteration) && Varint(cursor, end, size) && size <= (uint64_t)(end - cursor))
+	{
+		m_vecIteration.push_back((int)iteration);
+		m_vecOffset.push_back(cursor - &m_vecData[0]);
+		m_vecSize.push_back((size_t)size);
+
+		cursor += size;
+	}
+
+	return true;
+}
+
+bool CTraceReader::Seek(int episode)
+{
+	if (episode < 0 || episode >= NumEpisodes()) return false;
+
+	m_pCursor = &m_vecData[0] + m_vecOffset[episode];
+	m_pEnd = m_pCursor + m_vecSize[episode];
+	m_bFailed = false;
+	m_iNumSymbols = 0;
+	m_iSymbol = 0;
+
+	return true;
+}
+
+uint64_t CTraceReader::GetVarint()
+{
+	uint64_t value;
+
+	if (!Varint(m_pCursor, m_pEnd, value))
+	{
+		m_bFailed = true;
+
+		return 0;
+	}
+
+	return value;
+}
+
+void CTraceReader::GetRaw(void* data, size_t bytes)
+{
+	if ((size_t)(m_pEnd - m_pCursor) < bytes)
+	{
+		m_bFailed = true;
+		memset(data, 0, bytes);
+
+		return;
+	}
+
+	memcpy(data, m_pCursor, bytes);
+	m_pCursor += bytes;
+}
+
+bool CTraceReader::BeginTick()
+{
+	uint64_t count = GetVarint();
+
+	if (count == 0 || m_bFailed) return false;
+
+	m_iNumSymbols = (uint)(count - 1);
+	m_iSymbol = 0;
+
+	size_t bytes = (m_iNumSymbols + 3) / 4;
+
+	if ((size_t)(m_pEnd - m_pCursor) < bytes)
+	{
+		m_bFailed = true;
+
+		return false;
+	}
+
+	//the escapes follow the packed symbols
+	m_pSymbols = m_pCursor;
+	m_pCursor += bytes;
+
+	return true;
+}
+
+bool CTraceReader::Summary(uint &deaths, double &minesGathered)
+{
+	deaths = (uint)GetVarint();
+	GetRaw(&minesGathered, sizeof(minesGathered));
+
+	return !m_bFailed;
+}
@@ -0,0 +1,184 @@
+#ifndef CTRACE_H
+#define CTRACE_H
+//------------------------------------------------------------------------
+//
+//	Name: CTrace.h
+//
+//  Desc: Compact binary episode traces. A trace holds what is needed to
+//        re-simulate an episode without the learner: the layout of the
+//        world when it started and, for every tick, the action each live
+//        sweeper moved with.
+//
+//        Actions are 2 bit symbols packed four to a byte (what a symbol
+//        means is up to the controller - the discrete one stores each
+//        sweeper's heading, the continuous one whether it turned and which
+//        way), with raw escape values for whatever does not fit in a symbol.
+//        Layout numbers are LEB128 varints, signed ones zigzag encoded, so
+//        small deltas take a byte.
+//
+//        File layout: a 64 byte header, then one record per episode,
+//
+//          varint iteration, varint payload bytes, payload
+//
+//        and the payload is the controller's layout, the ticks (varint
+//        symbol count + 1, the packed symbols, the escapes) ending with a
+//        0, then the summary (varint deaths, raw double mines gathered)
+//        that a replay is checked against. An episode is buffered while it
+//        runs and written in one go when it ends, so a trace that is cut
+//        short only ever loses the episode in progress.
+//
+//------------------------------------------------------------------------
+#include <vector>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+const uint32_t TRACE_VERSION = 1;
+
+//which controller recorded a trace
+enum TraceWorld { DiscreteTrace, ContinuousTrace };
+
+struct STraceHeader
+{
+	char		magic[4];		//"SWTR"
+	uint32_t	version;
+	uint32_t	world;			//TraceWorld
+	uint32_t	seed;			//master seed of the recorded run
+	uint32_t	numSweepers;
+	uint32_t	numMines;
+	uint32_t	numSuperMines;
+	uint32_t	numRocks;
+	uint32_t	numTicks;
+	uint32_t	windowWidth;
+	uint32_t	windowHeight;
+	uint32_t	gridCellDim;
+	uint32_t	worldCellsX;	//iWorldCellsX/Y (0 in traces older than the setting)
+	uint32_t	worldCellsY;
+	uint32_t	reserved[2];
+};
+
+class CTraceWriter
+{
+private:
+	FILE*					m_pFile;
+
+	//payload of the episode being recorded
+	std::vector<uint8_t>	m_vecEpisode;
+	int						m_iIteration;
+	bool					m_bEpisodeOpen;
+
+	//escape values of the tick being recorded
+	std::vector<uint8_t>	m_vecEscapes;
+
+	uint64_t				m_iBytesWritten;
+	uint					m_iEpisodesWritten;
+
+	//a writer owns its file
+	CTraceWriter(const CTraceWriter&);
+	CTraceWriter& operator=(const CTraceWriter&);
+
+	static void	Varint(std::vector<uint8_t> &out, uint64_t value);
+
+public:
+	CTraceWriter();
+	~CTraceWriter();
+
+	//creates the file and writes the header, returns false if it cannot be written
+	bool		Open(const char* szFileName, const STraceHeader &header);
+	void		Close();
+
+	//starts buffering a new episode (the one in progress, if any, is dropped)
+	void		BeginEpisode(int iteration);
+
+	//layout values
+	void		PutVarint(uint64_t value){Varint(m_vecEpisode, value);}
+	void		PutSigned(int64_t value){Varint(m_vecEpisode, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));}
+	void		PutRaw(const void* data, size_t bytes);
+
+	//one tick: a symbol (0-3) per sweeper, in sweeper order, and the tick's
+	//escapes in any order around them
+	void		BeginTick();
+	void		PutSymbols(const int32_t* symbols, uint count);
+	void		PutEscape(const void* data, size_t bytes);
+	void		EndTick();
+
+	//closes the tick list with the episode's outcome and writes the record
+	bool		EndEpisode(uint deaths, double minesGathered);
+
+	//-------------------accessor functions
+	bool		IsOpen()const{return m_pFile != NULL;}
+	bool		EpisodeOpen()const{return m_bEpisodeOpen;}
+	uint64_t	BytesWritten()const{return m_iBytesWritten;}
+	uint		EpisodesWritten()const{return m_iEpisodesWritten;}
+};
+
+class CTraceReader
+{
+private:
+	std::vector<uint8_t>	m_vecData;
+	STraceHeader			m_Header;
+
+	//start of each episode's payload, its size and the iteration it was
+	std::vector<size_t>		m_vecOffset;
+	std::vector<size_t>		m_vecSize;
+	std::vector<int>		m_vecIteration;
+
+	//read position in the current episode
+	const uint8_t*			m_pCursor;
+	const uint8_t*			m_pEnd;
+	bool					m_bFailed;
+
+	//the tick being read
+	const uint8_t*			m_pSymbols;
+	uint					m_iSymbol;
+	uint					m_iNumSymbols;
+
+	static bool	Varint(const uint8_t* &cursor, const uint8_t* end, uint64_t &value);
+
+public:
+	CTraceReader();
+
+	//reads a whole trace and indexes its episodes. A truncated last record
+	//is ignored, so a trace still being written can be read
+	bool		Open(const char* szFileName);
+
+	//moves to the start of an episode's payload
+	bool		Seek(int episode);
+
+	//layout values
+	uint64_t	GetVarint();
+	int64_t		GetSigned()
+	{
+		uint64_t value = GetVarint();
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+	void		GetRaw(void* data, size_t bytes);
+
+	//starts the next tick, false once the episode has no more
+	bool		BeginTick();
+	uint		NumSymbols()const{return m_iNumSymbols;}
+	uint		GetSymbol()
+	{
+		if (m_iSymbol >= m_iNumSymbols){m_bFailed = true; return 0;}
+		uint symbol = (m_pSymbols[m_iSymbol >> 2] >> ((m_iSymbol & 3) * 2)) & 3;
+		++m_iSymbol;
+		return symbol;
+	}
+	void		GetEscape(void* data, size_t bytes){GetRaw(data, bytes);}
+
+	//the outcome recorded for the episode, once BeginTick has returned false
+	bool		Summary(uint &deaths, double &minesGathered);
+
+	//-------------------accessor functions
+	const STraceHeader&	Header()const{return m_Header;}
+	int			NumEpisodes()const{return (int)m_vecOffset.size();}
+	int			Iteration(int episode)const{return m_vecIteration[episode];}
+	size_t		EpisodeBytes(int episode)const{return m_vecSize[episode];}
+
+	//true once a read has run past the episode or past a tick's symbols
+	bool		Failed()const{return m_bFailed;}
+};
+
+#endif
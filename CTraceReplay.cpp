@@ -0,0 +1,68 @@
+#include "CTraceReplay.h"
+#include "CDiscController.h"
+#include "CContController.h"
+#include <iostream>
+
+CController* CreateTraceReplay(HWND hwndMain, const char* szFileName, int iteration)
+{
+	CTraceReader* reader = new CTraceReader;
+
+	if (!reader->Open(szFileName) || reader->NumEpisodes() == 0)
+	{
+		std::cout << "Could not read a recorded episode from " << szFileName << std::endl;
+		delete reader;
+
+		return NULL;
+	}
+
+	//the last episode recorded for that iteration
+	int episode = reader->NumEpisodes() - 1;
+
+	while (episode >= 0 && iteration >= 0 && reader->Iteration(episode) != iteration) --episode;
+
+	if (episode < 0)
+	{
+		std::cout << "Iteration " << iteration << " is not in " << szFileName << std::endl;
+		delete reader;
+
+		return NULL;
+	}
+
+	const STraceHeader &header = reader->Header();
+
+	CParams::iRandomSeed	= (int)header.seed;
+	CParams::iNumSweepers	= (int)header.numSweepers;
+	CParams::iNumMines		= (int)header.numMines;
+	CParams::iNumSuperMines	= (int)header.numSuperMines;
+	CParams::iNumRocks		= (int)header.numRocks;
+	CParams::iNumTicks		= (int)header.numTicks;
+	CParams::WindowWidth	= (int)header.windowWidth;
+	CParams::WindowHeight	= (int)header.windowHeight;
+	CParams::iGridCellDim	= (int)header.gridCellDim;
+	CParams::iWorldCellsX	= (int)header.worldCellsX;
+	CParams::iWorldCellsY	= (int)header.worldCellsY;
+	CParams::SetWorldSize();
+
+	CRandomService::SetMasterSeed(header.seed);
+
+	CController* controller;
+
+	if (header.world == DiscreteTrace)
+		controller = new CDiscController(hwndMain);
+	else
+		controller = new CContController(hwndMain);
+
+	controller->Initialize();
+
+	//the controller owns the reader from here on
+	if (!controller->StartReplay(reader, episode))
+	{
+		std::cout << "Episode " << episode << " of " << szFileName << " does not fit its world" << std::endl;
+		delete reader;
+		delete controller;
+
+		return NULL;
+	}
+
+	return controller;
+}
@@ -0,0 +1,20 @@
+#ifndef CTRACEREPLAY_H
+#define CTRACEREPLAY_H
+//------------------------------------------------------------------------
+//
+//	Name: CTraceReplay.h
+//
+//  Desc: Builds a controller that replays one episode of a recorded trace.
+//        The world sizes, counts and seed are taken from the trace header
+//        (and written into CParams), and the controller is a plain
+//        CDiscController or CContController - a replay needs no learning
+//        algorithm, the moves all come from the trace.
+//
+//------------------------------------------------------------------------
+#include "CController.h"
+
+//the episode of iteration 'iteration' (-1 for the last one in the trace),
+//NULL if the trace cannot be read or has no such episode
+CController* CreateTraceReplay(HWND hwndMain, const char* szFileName, int iteration);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+//------------------------------------------------------------------------
+//
+//	Name: Platform.h
+//
+//  Desc: The little of Win32 the simulation itself needs. The controllers
+//        only pass the window handle around and report errors with a
+//        message box; everything that draws (pens, Render, PlotStats) is
+//        compiled on Windows only. Elsewhere the handles are opaque and
+//        errors go to stderr, so the controllers build without a window
+//        (see trainer.cpp).
+//
+//------------------------------------------------------------------------
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else
+
+#include <iostream>
+
+typedef void*	HWND;
+typedef void*	HDC;
+
+#define MB_OK	0
+
+inline int MessageBox(HWND, const char *text, const char *caption, unsigned int)
+{
+	std::cerr << caption << ": " << text << std::endl;
+
+	return 0;
+}
+
+#endif
+
+#endif
@@ -13,6 +13,11 @@
 #include "CTimer.h"
 #include "resource.h"
 #include "CParams.h"
+#include "CRandom.h"
+#include "CActionSelector.h"
+#include "CDistanceField.h"
+#include "CSpatialGrid.h"
+#include "CTraceReplay.h"
 
 /*
 	Select your prac algorithm here
@@ -36,18 +41,41 @@ char*			szWindowClassName = "sweeper";
 //The controller class for this simulation
 CController*	g_pController	 = NULL; 
 
+//the learning controller while g_pController replays a recorded episode
+CController*	g_pLiveController = NULL;
+
 //create an instance of the parameter class.
 CParams   g_Params;
 
+//---------------------------- EndReplay --------------------------------
+//
+//	drops a replay that is running and puts the live controller back
+//-----------------------------------------------------------------------
+void EndReplay()
+{
+	if (!g_pLiveController) return;
+
+	delete g_pController;
+
+	g_pController = g_pLiveController;
+	g_pLiveController = NULL;
+}
+
 //---------------------------- Cleanup ----------------------------------
 //
 //	simply cleans up any memory issues when the application exits
 //-----------------------------------------------------------------------
 void Cleanup()
 {
+	EndReplay();
+
 	if (g_pController) 
+	{
+		//keep what was learned when checkpointing is on
+		if (CParams::iCheckpointInterval > 0) g_pController->SaveCheckpoint();
 
 		delete g_pController;
+	}
 }
 //-----------------------------------WinProc-----------------------------
 //
@@ -70,8 +98,14 @@ LRESULT CALLBACK WindowProc(HWND hwnd,
 	{	
 		case WM_CREATE: 
 		{
-			//seed the random number generator
-			srand((unsigned) time(NULL));
+			//seed the random number service - every stream is derived from this one
+			//seed, so a run can be reproduced by putting it into params.ini
+			if (CParams::iRandomSeed == 0)
+			{
+				CParams::iRandomSeed = (int)time(NULL);
+			}
+			CRandomService::SetMasterSeed((unsigned)CParams::iRandomSeed);
+			std::cout << "Master seed: " << CParams::iRandomSeed << std::endl;
 
 			//get the size of the client window
 			RECT rect;
@@ -83,6 +117,9 @@ LRESULT CALLBACK WindowProc(HWND hwnd,
 			//setup the controller
 			g_pController = new T(hwnd);
 			g_pController -> Initialize();
+
+			if (CParams::bRecordTrace) g_pController->StartRecording(CParams::sTraceFilename.c_str());
+
 			//create a surface for us to render to(backbuffer)
 			hdcBackBuffer = CreateCompatibleDC(NULL);
 
@@ -118,17 +155,109 @@ LRESULT CALLBACK WindowProc(HWND hwnd,
 					
 					break;
 
+				//save the learned tables to the checkpoint file
+				case 'S':
+					{
+						g_pController->SaveCheckpoint();
+					}
+
+					break;
+
+				//switch between learning and running the frozen greedy policy
+				case 'E':
+					{
+						g_pController->EvaluationToggle();
+					}
+
+					break;
+
+				//time the batch action selection kernels, the Q table layouts, the distance fields and the spatial grid
+				case 'B':
+					{
+						//the params file's sweepers, then batches big enough for the vector kernel to dominate
+						BenchmarkActionSelection(CParams::iNumSweepers, 10000);
+						BenchmarkActionSelection(3000, 1000);
+						BenchmarkActionSelection(50000, 60);
+
+						uint gridX = CParams::WorldWidth / CParams::iGridCellDim + 1;
+						uint gridY = CParams::WorldHeight / CParams::iGridCellDim + 1;
+
+						BenchmarkQTableLayouts(30, gridX, gridY, 20000);
+						BenchmarkQTableLayouts(3000, gridX, gridY, 200);
+
+						int spanX = CParams::WindowWidth / CParams::iGridCellDim;
+						int spanY = CParams::WindowHeight / CParams::iGridCellDim;
+
+						BenchmarkDistanceField(spanX, spanY, 30, 1000000);
+						BenchmarkDistanceField(spanX, spanY, 1000, 1000000);
+						BenchmarkDistanceField(spanX, spanY, 100000, 1000000);
+
+						BenchmarkSpatialGrid(CParams::WindowWidth, CParams::WindowHeight, 1000, 1000000);
+						BenchmarkSpatialGrid(CParams::WindowWidth, CParams::WindowHeight, 100000, 1000000);
+					}
+
+					break;
+
+				//scroll over a world bigger than the window, a quarter window at a time
+				case VK_LEFT:
+				case VK_RIGHT:
+				case VK_UP:
+				case VK_DOWN:
+					{
+						int dx = CParams::WindowWidth / CParams::iGridCellDim / 4;
+						int dy = CParams::WindowHeight / CParams::iGridCellDim / 4;
+
+						if (wparam == VK_LEFT) g_pController->ScrollView(-dx, 0);
+						if (wparam == VK_RIGHT) g_pController->ScrollView(dx, 0);
+						if (wparam == VK_UP) g_pController->ScrollView(0, -dy);
+						if (wparam == VK_DOWN) g_pController->ScrollView(0, dy);
+					}
+
+					break;
+
+				//replay an episode of the trace file (iReplayIteration, -1 for the
+				//latest one), or go back to the live run. The trace is read as it
+				//stands, so the live run can be recording it
+				case 'P':
+					{
+						if (g_pLiveController)
+						{
+							EndReplay();
+
+							break;
+						}
+
+						CController* replay = CreateTraceReplay(hwnd, CParams::sTraceFilename.c_str(),
+																CParams::iReplayIteration);
+
+						if (replay)
+						{
+							replay->FastRender(g_pController->FastRender());
+
+							g_pLiveController = g_pController;
+							g_pController = replay;
+						}
+					}
+
+					break;
+
         //reset the demo
         case 'R':
           {
+             EndReplay();
+
              if (g_pController)
              {
+               if (CParams::iCheckpointInterval > 0) g_pController->SaveCheckpoint();
+
                delete g_pController;
              }
 
              //setup the new controller
 			       g_pController = new T(hwnd);
 				   g_pController -> Initialize();
+
+				   if (CParams::bRecordTrace) g_pController->StartRecording(CParams::sTraceFilename.c_str());
           }
 
           break;
@@ -190,6 +319,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd,
 		case WM_DESTROY: 
 		{
 			SelectObject(hdcBackBuffer, hOldBitmap);
+			EndReplay();
 			delete g_pController;
 			g_pController = nullptr;
 			//clean up our backbuffer objects
@@ -0,0 +1,395 @@
+//------------------------------------------------------------------------
+//
+//	Name: sweep.cpp
+//
+//  Desc: Hyperparameter sweep runner. Runs the Q-learning controller on
+//        every combination of a grid of learning rates, discount factors,
+//        exploration rates, params files and seeds, and gathers all the
+//        per iteration deaths/average/most mines series into one csv.
+//
+//        The parameters and the random service are process wide statics,
+//        so every configuration runs in its own forked process, pinned to
+//        its own core, in its own run directory (where the controller's
+//        stats files and console output go). Nothing is shared between
+//        runs, so the sweep scales with the number of cores.
+//
+//        usage: sweep --iterations n [--learning-rates a,b,..]
+//                     [--discounts a,b,..] [--epsilons a,b,..]
+//                     [--params file,file,..] [--seeds n,n,..]
+//                     [--jobs n] [--dir runs] [--out sweep-results.csv]
+//
+//        Lists that are not given take their value from the params file.
+//
+//------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+#include "CParams.h"
+#include "CRandom.h"
+#include "CQLearningController.h"
+
+//marks a grid value that is taken from the params file
+const double FROM_PARAMS = -1;
+
+struct SSweepConfig
+{
+	double		learningRate;
+	double		discountFactor;
+	double		epsilon;
+	std::string	paramsFile;
+	int			seed;
+};
+
+struct SSweepOptions
+{
+	std::vector<double>			learningRates;
+	std::vector<double>			discountFactors;
+	std::vector<double>			epsilons;
+	std::vector<std::string>	paramsFiles;
+	std::vector<int>			seeds;
+	long						iterations;
+	int							jobs;
+	std::string					dir;
+	std::string					outFile;
+
+	SSweepOptions():iterations(0),
+					jobs(0),
+					dir("sweep-runs"),
+					outFile("sweep-results.csv")
+	{}
+};
+
+static void PrintUsage()
+{
+	std::cerr << "usage: sweep --iterations n [--learning-rates a,b,..] [--discounts a,b,..]\n"
+			  << "             [--epsilons a,b,..] [--params file,file,..] [--seeds n,n,..]\n"
+			  << "             [--jobs n] [--dir runs] [--out sweep-results.csv]" << std::endl;
+}
+
+//splits a comma separated list
+static std::vector<std::string> SplitList(const std::string &list)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(list);
+	std::string item;
+
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty()) items.push_back(item);
+	}
+
+	return items;
+}
+
+static std::vector<double> SplitDoubles(const std::string &list)
+{
+	std::vector<std::string> items = SplitList(list);
+	std::vector<double> values;
+
+	for (size_t i = 0; i < items.size(); ++i) values.push_back(atof(items[i].c_str()));
+
+	return values;
+}
+
+//------------------------------ParseOptions-------------------------------
+//
+//	returns false on an unknown option or a missing value
+//
+//-------------------------------------------------------------------------
+static bool ParseOptions(int argc, char** argv, SSweepOptions &options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if (i + 1 >= argc) return false;
+
+		std::string value = argv[++i];
+
+		if      (arg == "--learning-rates") options.learningRates   = SplitDoubles(value);
+		else if (arg == "--discounts")      options.discountFactors = SplitDoubles(value);
+		else if (arg == "--epsilons")       options.epsilons        = SplitDoubles(value);
+		else if (arg == "--params")         options.paramsFiles     = SplitList(value);
+		else if (arg == "--iterations")     options.iterations      = atol(value.c_str());
+		else if (arg == "--jobs")           options.jobs            = atoi(value.c_str());
+		else if (arg == "--dir")            options.dir             = value;
+		else if (arg == "--out")            options.outFile         = value;
+		else if (arg == "--seeds")
+		{
+			std::vector<std::string> seeds = SplitList(value);
+
+			for (size_t s = 0; s < seeds.size(); ++s) options.seeds.push_back(atoi(seeds[s].c_str()));
+		}
+		else return false;
+	}
+
+	//an axis that was not given has the single value from the params file
+	if (options.learningRates.empty())   options.learningRates.push_back(FROM_PARAMS);
+	if (options.discountFactors.empty()) options.discountFactors.push_back(FROM_PARAMS);
+	if (options.epsilons.empty())        options.epsilons.push_back(FROM_PARAMS);
+	if (options.paramsFiles.empty())     options.paramsFiles.push_back("params.ini");
+	if (options.seeds.empty())           options.seeds.push_back(0);
+
+	if (options.jobs <= 0) options.jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (options.jobs <= 0) options.jobs = 1;
+
+	return options.iterations > 0;
+}
+
+//the cartesian product of the grid axes
+static std::vector<SSweepConfig> BuildGrid(const SSweepOptions &options)
+{
+	std::vector<SSweepConfig> grid;
+
+	for (size_t p = 0; p < options.paramsFiles.size(); ++p)
+	for (size_t l = 0; l < options.learningRates.size(); ++l)
+	for (size_t d = 0; d < options.discountFactors.size(); ++d)
+	for (size_t e = 0; e < options.epsilons.size(); ++e)
+	for (size_t s = 0; s < options.seeds.size(); ++s)
+	{
+		SSweepConfig config;
+
+		config.paramsFile     = options.paramsFiles[p];
+		config.learningRate   = options.learningRates[l];
+		config.discountFactor = options.discountFactors[d];
+		config.epsilon        = options.epsilons[e];
+		config.seed           = options.seeds[s];
+
+		grid.push_back(config);
+	}
+
+	return grid;
+}
+
+static bool MakeDirectory(const std::string &path)
+{
+	return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+static std::string RunDirectory(const SSweepOptions &options, size_t run)
+{
+	return options.dir + "/run-" + itos((int)run);
+}
+
+//--------------------------------RunConfig--------------------------------
+//
+//	the body of a worker process: trains one configuration in its own run
+//	directory and writes its series (prefixed with the values it actually
+//	used) to results.csv there
+//
+//-------------------------------------------------------------------------
+static int RunConfig(const SSweepConfig &config, size_t run, const std::string &runDir, long iterations)
+{
+	//the params file path is relative to where the sweep was started
+	CParams params(config.paramsFile.c_str());
+
+	if (config.learningRate   != FROM_PARAMS) CParams::dLearningRate   = config.learningRate;
+	if (config.discountFactor != FROM_PARAMS) CParams::dDiscountFactor = config.discountFactor;
+	if (config.epsilon        != FROM_PARAMS) CParams::dEpsilon        = config.epsilon;
+	if (config.seed != 0)                     CParams::iRandomSeed     = config.seed;
+
+	//a sweep must be reproducible, so an unseeded config gets a fixed seed
+	if (CParams::iRandomSeed == 0) CParams::iRandomSeed = 1;
+
+	CRandomService::SetMasterSeed((unsigned)CParams::iRandomSeed);
+
+	if (chdir(runDir.c_str()) != 0) return 1;
+
+	//keep the controller's console output out of the other runs' way
+	if (!freopen("log.txt", "w", stdout)) return 1;
+
+	CQLearningController controller(NULL);
+	controller.Initialize();
+
+	while (controller.Iterations() < iterations)
+	{
+		if (!controller.Update()) return 1;
+	}
+
+	std::ofstream out("results.csv");
+
+	for (size_t i = 0; i < controller.AvMinesGathered().size(); ++i)
+	{
+		out << run << ","
+			<< CParams::dLearningRate << ","
+			<< CParams::dDiscountFactor << ","
+			<< CParams::dEpsilon << ","
+			<< config.paramsFile << ","
+			<< CParams::iRandomSeed << ","
+			<< i << ","
+			<< controller.AvMinesGathered()[i] << ","
+			<< controller.MostMinesGathered()[i] << ","
+			<< controller.Deaths()[i] << "\n";
+	}
+
+	return out ? 0 : 1;
+}
+
+//pins the calling process to one of the cores it is allowed on, by slot, so
+//more slots than cores (or a restricted cpuset) share the allowed ones out.
+//A run that cannot be pinned still goes ahead, unpinned
+static void PinToCore(int slot)
+{
+	cpu_set_t allowed;
+
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0)
+	{
+		std::cerr << "slot " << slot << ": cannot read the cpu affinity, running unpinned" << std::endl;
+
+		return;
+	}
+
+	int nth = slot % CPU_COUNT(&allowed);
+	int core = 0;
+
+	for (; core < CPU_SETSIZE; ++core)
+	{
+		if (CPU_ISSET(core, &allowed) && nth-- == 0) break;
+	}
+
+	cpu_set_t cpus;
+
+	CPU_ZERO(&cpus);
+	CPU_SET(core, &cpus);
+
+	if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+	{
+		std::cerr << "slot " << slot << ": cannot pin to core " << core << " (" << strerror(errno)
+				  << "), running unpinned" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	SSweepOptions options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+
+		return 1;
+	}
+
+	std::vector<SSweepConfig> grid = BuildGrid(options);
+
+	if (!MakeDirectory(options.dir))
+	{
+		std::cerr << "could not create " << options.dir << std::endl;
+
+		return 1;
+	}
+
+	std::cout << grid.size() << " configurations on " << options.jobs << " cores" << std::endl;
+
+	//the core each running worker is pinned to and when it started
+	std::vector<pid_t>	slotPid(options.jobs, 0);
+	std::vector<size_t>	slotRun(options.jobs, 0);
+	std::vector<double>	slotStart(options.jobs, 0);
+
+	double	start = HighResTime();
+	double	busyTime = 0;
+	int		running = 0;
+	int		failed = 0;
+	size_t	next = 0;
+
+	while (next < grid.size() || running > 0)
+	{
+		//start workers on the free cores
+		for (int slot = 0; slot < options.jobs && next < grid.size(); ++slot)
+		{
+			if (slotPid[slot] != 0) continue;
+
+			std::string runDir = RunDirectory(options, next);
+
+			if (!MakeDirectory(runDir))
+			{
+				std::cerr << "could not create " << runDir << std::endl;
+
+				return 1;
+			}
+
+			fflush(stdout);
+
+			pid_t pid = fork();
+
+			if (pid == 0)
+			{
+				PinToCore(slot);
+
+				_exit(RunConfig(grid[next], next, runDir, options.iterations));
+			}
+
+			if (pid < 0)
+			{
+				std::cerr << "fork failed" << std::endl;
+
+				return 1;
+			}
+
+			slotPid[slot] = pid;
+			slotRun[slot] = next;
+			slotStart[slot] = HighResTime();
+
+			++running;
+			++next;
+		}
+
+		//wait for any worker to finish
+		int status = 0;
+		pid_t pid = wait(&status);
+
+		if (pid < 0) break;
+
+		for (int slot = 0; slot < options.jobs; ++slot)
+		{
+			if (slotPid[slot] != pid) continue;
+
+			double runTime = HighResTime() - slotStart[slot];
+			bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+			busyTime += runTime;
+
+			std::cout << "run " << slotRun[slot] << (ok ? " done in " : " FAILED after ")
+					  << runTime << " s" << std::endl;
+
+			if (!ok) ++failed;
+
+			slotPid[slot] = 0;
+			--running;
+		}
+	}
+
+	double elapsed = HighResTime() - start;
+
+	//gather every run's series into one file
+	std::ofstream out(options.outFile.c_str());
+
+	out << "run,learning_rate,discount_factor,epsilon,params,seed,iteration,average_mines,most_mines,deaths\n";
+
+	for (size_t run = 0; run < grid.size(); ++run)
+	{
+		std::ifstream in((RunDirectory(options, run) + "/results.csv").c_str());
+
+		//a failed run may have left no series behind
+		if (in && in.peek() != EOF) out << in.rdbuf();
+	}
+
+	std::cout << "\n" << grid.size() << " runs in " << elapsed << " s ("
+			  << busyTime << " s of runs, " << busyTime / elapsed << "x parallel), results in "
+			  << options.outFile << std::endl;
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,669 @@
+//------------------------------------------------------------------------
+//
+//	Name: trainer.cpp
+//
+//  Desc: Headless batch trainer. Runs the Q-learning or backprop controller
+//        without a window for a number of iterations and/or a wall clock
+//        budget, as fast as the simulation can go, then reports ticks/sec
+//        and episodes (iterations) per second and writes the per iteration
+//        stats to a results file.
+//
+//        usage: trainer [--controller qlearning|backprop] [--iterations n]
+//                       [--seconds s] [--params file] [--seed n]
+//                       [--value-type int|float|double|fixed16]
+//                       [--evaluate] [--out file] [--record file]
+//                       [--scenarios file] [--count-allocations]
+//               trainer --make-scenarios file --layouts n
+//                       [--controller qlearning|backprop] [--seed n]
+//               trainer --replay file [--episode n]
+//               trainer --benchmark
+//               trainer --scaling [--seed n]
+//
+//        --value-type picks the Q value storage of the Q-learning
+//        controller (float by default). --evaluate runs the frozen greedy
+//        policy compiled from the (warm started) tables instead of
+//        learning, like bEvaluate in the params file. --record writes
+//        every episode to a trace file (bRecordTrace records to
+//        sTraceFilename), --replay plays the episode of iteration n (the
+//        last one by default) back from one and checks it ends the way the
+//        recording did. --benchmark times the action selection kernels,
+//        the Q table layouts, the distance fields, the spatial grid and
+//        the occupancy index instead of training.
+//        --scaling reports the memory and ticks/sec of the discrete world
+//        at sizes up to 4096 x 4096 cells, with the params file's object
+//        density.
+//
+//        --count-allocations counts the heap allocations made by the
+//        ticks after the first iteration (the update that rolls into the
+//        next iteration is left out) and fails the run if there are any:
+//        a steady state tick should only reuse memory it already has.
+//
+//        --make-scenarios writes a bank of n random layouts for the
+//        controller's world (discrete for qlearning, continuous for
+//        backprop) as the params file sizes it. --scenarios starts the
+//        episodes from a bank's layouts, like bUseScenarios.
+//
+//------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <atomic>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+#include "CParams.h"
+#include "CRandom.h"
+#include "CQLearningController.h"
+#include "CBackPropController.h"
+#include "CDistanceField.h"
+#include "CSpatialGrid.h"
+#include "CTraceReplay.h"
+#include "CScenario.h"
+
+//the wall clock budget is only checked every this many updates
+const long TIME_CHECK_INTERVAL = 1024;
+
+//world sizes (cells a side) of the scaling report, after the window's own
+const int SCALING_SIZES[] = {256, 1024, 2048, 4096};
+
+//----------------------------allocation counting--------------------------
+//
+//	every new in the process is counted, from any thread. The array and
+//	sized forms are all replaced too, so that every new is paired with a
+//	delete from the same family
+//
+//-------------------------------------------------------------------------
+static std::atomic<long> g_lAllocations(0);
+
+//the malloc and the frees are kept out of line: where gcc can see them it
+//takes them for a mismatch with the new or delete around them
+//(-Wmismatched-new-delete)
+__attribute__((noinline)) static void* CountedAlloc(size_t size)
+{
+	g_lAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* p = malloc(size ? size : 1);
+
+	if (!p) throw std::bad_alloc();
+
+	return p;
+}
+
+void* operator new(size_t size)
+{
+	return CountedAlloc(size);
+}
+
+void* operator new[](size_t size)
+{
+	return CountedAlloc(size);
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+struct STrainerOptions
+{
+	std::string	controller;
+	std::string	valueType;
+	bool		evaluate;
+	bool		benchmark;
+	bool		scaling;
+	bool		countAllocations;
+	long		iterations;
+	double		seconds;
+	std::string	paramsFile;
+	int			seed;
+	std::string	outFile;
+	std::string	recordFile;
+	std::string	replayFile;
+	int			episode;
+	std::string	scenarioFile;
+	std::string	makeScenarios;
+	long		layouts;
+
+	STrainerOptions():controller("qlearning"),
+					  valueType("float"),
+					  evaluate(false),
+					  benchmark(false),
+					  scaling(false),
+					  countAllocations(false),
+					  iterations(0),
+					  seconds(0),
+					  paramsFile("params.ini"),
+					  seed(0),
+					  outFile("trainer-results.csv"),
+					  episode(-1),
+					  layouts(0)
+	{}
+};
+
+static void PrintUsage()
+{
+	std::cerr << "usage: trainer [--controller qlearning|backprop] [--iterations n]\n"
+			  << "               [--seconds s] [--params file] [--seed n]\n"
+			  << "               [--value-type int|float|double|fixed16] [--evaluate]\n"
+			  << "               [--out file] [--record file] [--scenarios file]\n"
+			  << "               [--count-allocations]\n"
+			  << "       trainer --make-scenarios file --layouts n\n"
+			  << "               [--controller qlearning|backprop] [--seed n]\n"
+			  << "       trainer --replay file [--episode n]\n"
+			  << "       trainer --benchmark\n"
+			  << "       trainer --scaling [--seed n]\n"
+			  << "at least one of --iterations and --seconds must be given" << std::endl;
+}
+
+//------------------------------ParseOptions-------------------------------
+//
+//	returns false on an unknown option or a missing value
+//
+//-------------------------------------------------------------------------
+static bool ParseOptions(int argc, char** argv, STrainerOptions &options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		//the options without a value
+		if (arg == "--evaluate")
+		{
+			options.evaluate = true;
+			continue;
+		}
+		if (arg == "--benchmark")
+		{
+			options.benchmark = true;
+			continue;
+		}
+		if (arg == "--scaling")
+		{
+			options.scaling = true;
+			continue;
+		}
+		if (arg == "--count-allocations")
+		{
+			options.countAllocations = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) return false;
+
+		const char* value = argv[++i];
+
+		if      (arg == "--controller") options.controller = value;
+		else if (arg == "--iterations") options.iterations = atol(value);
+		else if (arg == "--seconds")    options.seconds    = atof(value);
+		else if (arg == "--params")     options.paramsFile = value;
+		else if (arg == "--seed")       options.seed       = atoi(value);
+		else if (arg == "--value-type") options.valueType  = value;
+		else if (arg == "--out")        options.outFile    = value;
+		else if (arg == "--record")     options.recordFile = value;
+		else if (arg == "--replay")     options.replayFile = value;
+		else if (arg == "--episode")    options.episode    = atoi(value);
+		else if (arg == "--scenarios")  options.scenarioFile = value;
+		else if (arg == "--make-scenarios") options.makeScenarios = value;
+		else if (arg == "--layouts")    options.layouts    = atol(value);
+		else return false;
+	}
+
+	if (!options.makeScenarios.empty()) return options.layouts > 0;
+
+	return options.benchmark || options.scaling || !options.replayFile.empty() ||
+		   options.iterations > 0 || options.seconds > 0;
+}
+
+//------------------------------WriteResults-------------------------------
+//
+//	one line per completed iteration
+//
+//-------------------------------------------------------------------------
+static bool WriteResults(const CController &controller, const std::string &filename)
+{
+	std::ofstream out(filename.c_str());
+
+	if (!out) return false;
+
+	out << "iteration,average_mines,most_mines,deaths\n";
+
+	for (size_t i = 0; i < controller.AvMinesGathered().size(); ++i)
+	{
+		out << i << ","
+			<< controller.AvMinesGathered()[i] << ","
+			<< controller.MostMinesGathered()[i] << ","
+			<< controller.Deaths()[i] << "\n";
+	}
+
+	return true;
+}
+
+//---------------------------RunOccupancyBenchmark--------------------------
+//
+//	the discrete world of the params file with more and more objects, in
+//	the params file's proportions. Each gets its occupancy index timed
+//	against the scans, then an iteration's worth of Q-learning ticks,
+//	whose cost should not grow with the objects
+//
+//-------------------------------------------------------------------------
+static void RunOccupancyBenchmark(void)
+{
+	static const int OBJECT_COUNTS[] = {60, 1000, 10000, 100000};
+
+	int mines = CParams::iNumMines, superMines = CParams::iNumSuperMines, rocks = CParams::iNumRocks;
+	double total = mines + superMines + rocks;
+
+	std::vector<std::string> report;
+
+	for (size_t n = 0; n < sizeof(OBJECT_COUNTS) / sizeof(OBJECT_COUNTS[0]); ++n)
+	{
+		double scale = total > 0 ? OBJECT_COUNTS[n] / total : 0;
+
+		CParams::iNumMines = (int)(mines * scale + 0.5);
+		CParams::iNumSuperMines = (int)(superMines * scale + 0.5);
+		CParams::iNumRocks = (int)(rocks * scale + 0.5);
+
+		CQLearningControllerT<float>* controller = new CQLearningControllerT<float>(NULL);
+		controller->Initialize();
+		controller->BenchmarkOccupancyIndex(1000000);
+
+		//with many supermines the sweepers are soon all dead, so the ticks are gathered over
+		//as many iterations as it takes. The updates that end an iteration reset the world,
+		//and are left out
+		long ticks = 0;
+		double elapsed = 0;
+
+		while (ticks < CParams::iNumTicks)
+		{
+			int iteration = controller->Iterations();
+			double start = HighResTime();
+
+			if (!controller->Update()) break;
+
+			if (controller->Iterations() == iteration)
+			{
+				elapsed += HighResTime() - start;
+				++ticks;
+			}
+		}
+
+		char line[128];
+		sprintf(line, "%10d %14.3f", CParams::iNumMines + CParams::iNumSuperMines + CParams::iNumRocks,
+				ticks > 0 ? elapsed / ticks * 1e6 : 0);
+		report.push_back(line);
+
+		delete controller;
+	}
+
+	CParams::iNumMines = mines;
+	CParams::iNumSuperMines = superMines;
+	CParams::iNumRocks = rocks;
+
+	std::cout << "\n   objects    us per tick\n";
+
+	for (size_t r = 0; r < report.size(); ++r) std::cout << report[r] << "\n";
+
+	std::cout << std::flush;
+}
+
+//------------------------------RunBenchmarks------------------------------
+//
+//	the microbenchmarks the GUI runs on 'B', at the params file's sizes
+//
+//-------------------------------------------------------------------------
+static void RunBenchmarks(void)
+{
+	//the params file's sweepers, then batches big enough for the vector kernel to dominate
+	BenchmarkActionSelection(CParams::iNumSweepers, 10000);
+	BenchmarkActionSelection(3000, 1000);
+	BenchmarkActionSelection(50000, 60);
+
+	uint gridX = CParams::WorldWidth / CParams::iGridCellDim + 1;
+	uint gridY = CParams::WorldHeight / CParams::iGridCellDim + 1;
+
+	BenchmarkQTableLayouts(30, gridX, gridY, 20000);
+	BenchmarkQTableLayouts(3000, gridX, gridY, 200);
+
+	int spanX = CParams::WindowWidth / CParams::iGridCellDim;
+	int spanY = CParams::WindowHeight / CParams::iGridCellDim;
+
+	BenchmarkDistanceField(spanX, spanY, 30, 1000000);
+	BenchmarkDistanceField(spanX, spanY, 1000, 1000000);
+	BenchmarkDistanceField(spanX, spanY, 100000, 1000000);
+
+	BenchmarkSpatialGrid(CParams::WindowWidth, CParams::WindowHeight, 1000, 1000000);
+	BenchmarkSpatialGrid(CParams::WindowWidth, CParams::WindowHeight, 100000, 1000000);
+
+	RunOccupancyBenchmark();
+}
+
+//------------------------------RunScalingReport---------------------------
+//
+//	one iteration of the Q-learning controller per world size. The number
+//	of objects grows with the number of cells, and the states are the local
+//	view (a position state needs a Q table row per cell). Setup covers the
+//	placement and the index, reset the rollover into the next iteration and
+//	memory is what WorldBytes counts
+//
+//-------------------------------------------------------------------------
+static void RunScalingReport(void)
+{
+	double windowCells = (CParams::WindowWidth / CParams::iGridCellDim) * (CParams::WindowHeight / CParams::iGridCellDim);
+	int mines = CParams::iNumMines, superMines = CParams::iNumSuperMines, rocks = CParams::iNumRocks;
+
+	CParams::iStateEncoding = 1;
+
+	std::vector<std::string> report;
+
+	for (int s = -1; s < (int)(sizeof(SCALING_SIZES) / sizeof(SCALING_SIZES[0])); ++s)
+	{
+		CParams::iWorldCellsX = CParams::iWorldCellsY = s < 0 ? 0 : SCALING_SIZES[s];
+		CParams::SetWorldSize();
+
+		double scale = (CParams::WorldWidth / CParams::iGridCellDim) * (double)(CParams::WorldHeight / CParams::iGridCellDim) / windowCells;
+
+		CParams::iNumMines = (int)(mines * scale);
+		CParams::iNumSuperMines = (int)(superMines * scale);
+		CParams::iNumRocks = (int)(rocks * scale);
+
+		double start = HighResTime();
+
+		CQLearningControllerT<float>* controller = new CQLearningControllerT<float>(NULL);
+		controller->Initialize();
+
+		double setup = HighResTime() - start;
+		long ticks = 0;
+
+		start = HighResTime();
+
+		double ticksEnd = start;
+
+		//the update that ends the iteration resets the world, and is timed on its own
+		while (controller->Iterations() == 0 && controller->Update())
+		{
+			if (controller->Iterations() == 0)
+			{
+				++ticks;
+				ticksEnd = HighResTime();
+			}
+		}
+
+		double elapsed = ticksEnd - start;
+		double reset = HighResTime() - ticksEnd;
+
+		char line[256];
+		sprintf(line, "%5d x %-5d %10d %-9s %10.1f %9.3f %11.0f %9.3f",
+				CParams::WorldWidth / CParams::iGridCellDim, CParams::WorldHeight / CParams::iGridCellDim,
+				CParams::iNumMines + CParams::iNumSuperMines + CParams::iNumRocks,
+				controller->BitboardWorld() ? "bitboard" : "chains",
+				controller->WorldBytes() / 1048576.0, setup, elapsed > 0 ? ticks / elapsed : 0, reset);
+		report.push_back(line);
+
+		delete controller;
+	}
+
+	std::cout << "\nworld (cells)    objects storage   world MB   setup s   ticks/sec   reset s\n";
+
+	for (size_t r = 0; r < report.size(); ++r) std::cout << report[r] << "\n";
+
+	std::cout << std::flush;
+}
+
+//------------------------------RunReplay----------------------------------
+//
+//	one pass through a recorded episode at full speed. Returns false if it
+//	cannot be replayed or does not end the way it was recorded
+//
+//-------------------------------------------------------------------------
+static bool RunReplay(const STrainerOptions &options)
+{
+	CController* controller = CreateTraceReplay(NULL, options.replayFile.c_str(), options.episode);
+
+	if (!controller) return false;
+
+	long	ticks = 0;
+	double	start = HighResTime();
+
+	while (controller->Iterations() == 0 && controller->Update())
+	{
+		if (controller->Iterations() == 0) ++ticks;
+	}
+
+	double elapsed = HighResTime() - start;
+
+	bool ok = controller->Replaying() && controller->ReplayMatched();
+
+	std::cout << "\nreplay: " << ticks << " ticks in " << elapsed << " s";
+	if (elapsed > 0) std::cout << " (" << ticks / elapsed << " ticks/sec)";
+	std::cout << ", " << (ok ? "matches the recording" : "does NOT match the recording") << std::endl;
+
+	delete controller;
+
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	STrainerOptions options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+
+		return 1;
+	}
+
+	CParams params(options.paramsFile.c_str());
+
+	if (options.benchmark)
+	{
+		RunBenchmarks();
+
+		return 0;
+	}
+
+	if (!options.replayFile.empty())
+	{
+		return RunReplay(options) ? 0 : 1;
+	}
+
+	if (options.seed != 0)
+	{
+		CParams::iRandomSeed = options.seed;
+	}
+
+	if (options.evaluate)
+	{
+		CParams::bEvaluate = true;
+	}
+
+	//same seeding as the GUI, so a seed reproduces the same run in either
+	if (CParams::iRandomSeed == 0)
+	{
+		CParams::iRandomSeed = (int)time(NULL);
+	}
+	CRandomService::SetMasterSeed((unsigned)CParams::iRandomSeed);
+	std::cout << "Master seed: " << CParams::iRandomSeed << std::endl;
+
+	if (options.scaling)
+	{
+		RunScalingReport();
+
+		return 0;
+	}
+
+	if (!options.makeScenarios.empty())
+	{
+		TraceWorld world = options.controller == "backprop" ? ContinuousTrace : DiscreteTrace;
+
+		if (!GenerateScenarioBank(options.makeScenarios.c_str(), world, (uint)options.layouts))
+		{
+			std::cerr << "could not write " << options.makeScenarios << std::endl;
+
+			return 1;
+		}
+
+		std::cout << options.layouts << " layouts written to " << options.makeScenarios << std::endl;
+
+		return 0;
+	}
+
+	if (!options.scenarioFile.empty())
+	{
+		CParams::bUseScenarios = true;
+		CParams::sScenarioFilename = options.scenarioFile;
+	}
+
+	CController* controller = NULL;
+
+	if (options.controller == "qlearning")
+	{
+		if      (options.valueType == "int")     controller = new CQLearningControllerT<int>(NULL);
+		else if (options.valueType == "float")   controller = new CQLearningControllerT<float>(NULL);
+		else if (options.valueType == "double")  controller = new CQLearningControllerT<double>(NULL);
+		else if (options.valueType == "fixed16") controller = new CQLearningControllerT<SFixed16>(NULL);
+		else
+		{
+			std::cerr << "unknown value type: " << options.valueType << std::endl;
+			PrintUsage();
+
+			return 1;
+		}
+	}
+	else if (options.controller == "backprop")
+	{
+		controller = new CBackPropController(NULL);
+	}
+	else
+	{
+		std::cerr << "unknown controller: " << options.controller << std::endl;
+		PrintUsage();
+
+		return 1;
+	}
+
+	controller->Initialize();
+
+	if (options.recordFile.empty() && CParams::bRecordTrace)
+	{
+		options.recordFile = CParams::sTraceFilename;
+	}
+
+	if (!options.recordFile.empty() && !controller->StartRecording(options.recordFile.c_str()))
+	{
+		std::cerr << "could not record to " << options.recordFile << std::endl;
+		delete controller;
+
+		return 1;
+	}
+
+	long	ticks = 0;
+	long	updates = 0;
+	bool	ok = true;
+
+	//heap allocations of the steady state ticks, and how many were counted
+	long	tickAllocations = 0;
+	long	countedTicks = 0;
+
+	double	start = HighResTime();
+	double	elapsed = 0;
+
+	while (options.iterations <= 0 || controller->Iterations() < options.iterations)
+	{
+		int iteration = controller->Iterations();
+		long allocations = g_lAllocations.load(std::memory_order_relaxed);
+
+		if (!controller->Update())
+		{
+			ok = false;
+
+			break;
+		}
+
+		//the update that ends an iteration only resets the world
+		if (controller->Iterations() == iteration)
+		{
+			++ticks;
+
+			if (options.countAllocations && iteration > 0)
+			{
+				tickAllocations += g_lAllocations.load(std::memory_order_relaxed) - allocations;
+				++countedTicks;
+			}
+		}
+
+		if (options.seconds > 0 && ++updates % TIME_CHECK_INTERVAL == 0 &&
+			HighResTime() - start >= options.seconds)
+		{
+			break;
+		}
+	}
+
+	elapsed = HighResTime() - start;
+
+	std::cout << "\n" << options.controller << ": "
+			  << controller->Iterations() << " iterations, "
+			  << ticks << " ticks in " << elapsed << " s" << std::endl;
+
+	if (elapsed > 0)
+	{
+		std::cout << "  ticks/sec:          " << ticks / elapsed << "\n"
+				  << "  sweeper steps/sec:  " << ticks * (double)controller->NumSweepers() / elapsed << "\n"
+				  << "  episodes/sec:       " << controller->Iterations() / elapsed << std::endl;
+	}
+
+	if (options.countAllocations)
+	{
+		std::cout << "  heap allocations:   " << tickAllocations << " in " << countedTicks
+				  << " steady state ticks" << std::endl;
+
+		if (countedTicks == 0)
+		{
+			std::cerr << "no steady state ticks to count (run at least 2 iterations)" << std::endl;
+			ok = false;
+		}
+		else if (tickAllocations > 0)
+		{
+			std::cerr << "steady state ticks allocated memory" << std::endl;
+			ok = false;
+		}
+	}
+
+	if (controller->Recording())
+	{
+		std::cout << "  trace:              " << controller->Recorder()->EpisodesWritten() << " episodes, "
+				  << controller->Recorder()->BytesWritten() << " bytes in " << options.recordFile << std::endl;
+	}
+
+	if (CParams::iCheckpointInterval > 0) controller->SaveCheckpoint();
+
+	if (!WriteResults(*controller, options.outFile))
+	{
+		std::cerr << "could not write " << options.outFile << std::endl;
+		ok = false;
+	}
+
+	delete controller;
+
+	return ok ? 0 : 1;
+}
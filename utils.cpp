@@ -1,5 +1,10 @@
 #include "utils.h"
 #include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <chrono>
+#endif
 
 
 
@@ -49,3 +54,20 @@ void Clamp(double &arg, double min, double max)
 	}
 }
 
+//-------------------------------------HighResTime()-----------------------------------
+//
+//	returns a time stamp in seconds from the highest resolution clock available.
+//	Only differences between two calls are meaningful.
+//
+//-------------------------------------------------------------------------------------
+double HighResTime()
+{
+#ifdef _WIN32
+	LONGLONG count, freq;
+	QueryPerformanceCounter((LARGE_INTEGER*) &count);
+	QueryPerformanceFrequency((LARGE_INTEGER*) &freq);
+	return (double)count / (double)freq;
+#else
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
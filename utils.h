@@ -10,27 +10,8 @@
 
 using namespace std;
 
-//----------------------------------------------------------------------------
-//	some random number functions.
-//----------------------------------------------------------------------------
-
-//returns a random integer between x and y
-inline int	  RandInt(int x,int y) {return rand()%(y-x+1)+x;}
-
-//returns a random float between zero and 1
-inline double RandFloat()		   {return (rand())/(RAND_MAX+1.0);}
-
-//returns a random bool
-inline bool   RandBool()
-{
-	if (RandInt(0,1)) return true;
-
-	else return false;
-}
-
-//returns a random float in the range -1 < n < 1
-inline double RandomClamped()	   {return RandFloat() - RandFloat();}
-
+//random numbers come from the streams of CRandom.h - there are no global
+//rand() helpers, so nothing can share (or reseed) the C library's state
 
 //-----------------------------------------------------------------------
 //	
@@ -46,6 +27,9 @@ string ftos (float arg);
 //	clamps the first argument between the second two
 void Clamp(double &arg, double min, double max);
 
+//returns a high resolution time stamp in seconds (used for profiling)
+double HighResTime();
+
 /////////////////////////////////////////////////////////////////////
 //
 //	Point structure